@@ -2,6 +2,8 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <cstdint>
+#include <cstring>
 #include <vector>
 #include <type_traits>
 #include <iterator>
@@ -121,4 +123,82 @@ namespace Algorithm
 		return BINARY_SEARCH_INVALID_INDEX;
 	}
 
+	// LSD radix sort for 32 bit keys, 8 bits a pass. scratch must hold count values.
+	// Passes where every key has the same digit are skipped, so narrow key ranges only pay for the digits they use.
+	inline void radix_sort(uint32_t* values, size_t count, uint32_t* scratch)
+	{
+		if (count < 2)
+		{
+			return;
+		}
+
+		size_t histograms[4][256] = {};
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t value = values[i];
+			++histograms[0][value & 0xFF];
+			++histograms[1][(value >> 8) & 0xFF];
+			++histograms[2][(value >> 16) & 0xFF];
+			++histograms[3][value >> 24];
+		}
+
+		uint32_t* src = values;
+		uint32_t* dst = scratch;
+		for (uint32_t pass = 0; pass < 4; ++pass)
+		{
+			const uint32_t shift = pass * 8;
+			size_t* histogram = histograms[pass];
+			if (histogram[(src[0] >> shift) & 0xFF] == count)
+			{
+				continue;
+			}
+
+			size_t offset = 0;
+			for (uint32_t digit = 0; digit < 256; ++digit)
+			{
+				const size_t digitCount = histogram[digit];
+				histogram[digit] = offset;
+				offset += digitCount;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const uint32_t value = src[i];
+				dst[histogram[(value >> shift) & 0xFF]++] = value;
+			}
+
+			std::swap(src, dst);
+		}
+
+		if (src != values)
+		{
+			memcpy(values, src, count * sizeof(uint32_t));
+		}
+	}
+
+	// Signed keys just have their sign bit flipped around the unsigned sort.
+	inline void radix_sort(int32_t* values, size_t count, int32_t* scratch)
+	{
+		uint32_t* keys = reinterpret_cast<uint32_t*>(values);
+		for (size_t i = 0; i < count; ++i)
+		{
+			keys[i] ^= 0x80000000U;
+		}
+
+		radix_sort(keys, count, reinterpret_cast<uint32_t*>(scratch));
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			keys[i] ^= 0x80000000U;
+		}
+	}
+
+	template<typename T>
+	void radix_sort(std::vector<T>& values)
+	{
+		static_assert(std::is_same<T, uint32_t>::value || std::is_same<T, int32_t>::value, "radix_sort only supports 32 bit keys.");
+		std::vector<T> scratch(values.size());
+		radix_sort(values.data(), values.size(), scratch.data());
+	}
+
 } // Algorithm
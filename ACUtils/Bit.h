@@ -209,7 +209,7 @@ namespace Bits
 
 	constexpr uint32_t PopCount64(uint64_t value)
 	{
-		return (value == ~0UL) ? 64 : (uint32_t)__popcnt64(value);
+		return (uint32_t)__popcnt64(value);
 	}
 
 	inline uint32_t PopCount128(const Bitfield128& value)
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "Memory.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Deferred (binary) logging.
+// Push() copies the format pointer and the raw argument values into a lock free ring owned by the calling thread; nothing
+// is formatted until a consumer calls Drain(). Format strings must be literals (or otherwise outlive the drain), string
+// arguments are copied so temporaries are fine. Any thread may push, only one thread may drain.
+// Thread rings are tracked through a thread_local, so there should only be one Logger per process.
+namespace DeferredLog
+{
+	typedef int (*FormatFunc)(char* outBuffer, size_t outSize, const char* fmt, const void* args, const char* strings);
+
+	struct Entry
+	{
+		FormatFunc format;
+		const char* fmt;
+		double timestamp;
+		uint32_t argsSize;  // Packed argument tuple, directly after the entry.
+		uint32_t stringsSize; // Copied string arguments, directly after the tuple.
+	};
+
+	// How each argument is stored in the ring. Plain values are copied as is.
+	template<typename T>
+	struct PackedArg
+	{
+		typedef T StoredType;
+
+		static size_t StringBytes(const T& /*value*/) { return 0; }
+		static StoredType Store(const T& value, char* /*strings*/, uint32_t& /*stringOffset*/) { return value; }
+		static const T& Load(const StoredType& stored, const char* /*strings*/) { return stored; }
+	};
+
+	// Strings are copied into the entry and stored as an offset from the start of the string block.
+	template<>
+	struct PackedArg<const char*>
+	{
+		typedef uint32_t StoredType;
+
+		static const char* Sanitize(const char* value) { return value ? value : "(null)"; }
+		static size_t StringBytes(const char* value) { return strlen(Sanitize(value)) + 1; }
+		static StoredType Store(const char* value, char* strings, uint32_t& stringOffset)
+		{
+			const uint32_t offset = stringOffset;
+			const size_t length = StringBytes(value);
+			memcpy(strings + offset, Sanitize(value), length);
+			stringOffset += (uint32_t)length;
+			return offset;
+		}
+		static const char* Load(StoredType stored, const char* strings) { return strings + stored; }
+	};
+
+	template<>
+	struct PackedArg<char*> : public PackedArg<const char*>
+	{
+	};
+
+	template<typename ...Args>
+	struct Formatter
+	{
+		typedef std::tuple<typename PackedArg<Args>::StoredType...> Storage;
+
+		static int Format(char* outBuffer, size_t outSize, const char* fmt, const void* args, const char* strings)
+		{
+			return FormatImpl(outBuffer, outSize, fmt, *(const Storage*)args, strings, std::index_sequence_for<Args...>());
+		}
+
+	private:
+		template<size_t ...I>
+		static int FormatImpl(char* outBuffer, size_t outSize, const char* fmt, const Storage& args, const char* strings, std::index_sequence<I...>)
+		{
+			return snprintf(outBuffer, outSize, fmt, PackedArg<Args>::Load(std::get<I>(args), strings)...);
+		}
+	};
+
+	class Logger
+	{
+	public:
+		static constexpr size_t THREAD_BUFFER_SIZE = 1 * 1024 * 1024;
+
+		Logger()
+		: m_rings(THREAD_BUFFER_SIZE),
+		m_dropped(0ULL)
+		{
+		}
+
+		// Returns false (and nothing is written) if this thread's ring is full. Call Drain, or accept the drop.
+		template<typename ...Args>
+		bool Push(double timestamp, const char* fmt, Args... args)
+		{
+			typedef Formatter<typename std::decay<Args>::type...> ArgFormatter;
+			typedef typename ArgFormatter::Storage Storage;
+
+			size_t stringBytes = 0;
+			int expand[] = { 0, ((stringBytes += PackedArg<typename std::decay<Args>::type>::StringBytes(args)), 0)... };
+			(void)expand;
+
+			const size_t argsSize = (sizeof(Storage) + 7) & ~(size_t)7;
+			Memory::SPSCRingbuffer* ring = m_rings.GetThreadRing();
+			Entry* entry = ring ? (Entry*)ring->Reserve(sizeof(Entry) + argsSize + stringBytes) : nullptr;
+			if (!entry)
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			entry->format = &ArgFormatter::Format;
+			entry->fmt = fmt;
+			entry->timestamp = timestamp;
+			entry->argsSize = (uint32_t)argsSize;
+			entry->stringsSize = (uint32_t)stringBytes;
+
+			char* strings = (char*)(entry + 1) + argsSize;
+			uint32_t stringOffset = 0;
+			new (entry + 1) Storage(PackedArg<typename std::decay<Args>::type>::Store(args, strings, stringOffset)...);
+
+			ring->Commit();
+			return true;
+		}
+
+		// Formats every pending entry (per thread, in push order) and hands it to the sink. Single consumer only.
+		template<typename Sink>
+		uint32_t Drain(Sink sink)
+		{
+			char formatBuffer[1024];
+			uint32_t drained = 0;
+			const uint32_t numRings = m_rings.GetNumRings();
+			for (uint32_t i = 0; i < numRings; ++i)
+			{
+				Memory::SPSCRingbuffer* ring = m_rings.GetRing(i);
+				if (!ring)
+				{
+					continue;
+				}
+
+				while (const Entry* entry = (const Entry*)ring->Peek())
+				{
+					const char* args = (const char*)(entry + 1);
+					(*entry->format)(formatBuffer, sizeof(formatBuffer), entry->fmt, args, args + entry->argsSize);
+					sink(entry->timestamp, (const char*)formatBuffer);
+					ring->Pop();
+					++drained;
+				}
+			}
+
+			return drained;
+		}
+
+		uint64_t GetDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+	private:
+		Memory::ThreadRingRegistry<Logger> m_rings;
+		std::atomic<uint64_t> m_dropped;
+	};
+}
@@ -31,6 +31,9 @@ public:
 
 	char GetChar() { char out; m_fileStream.get(out); return out; }
 
+	// Raw read of up to size bytes, returns how many were read. Zero at EOF.
+	size_t Read(char* buffer, size_t size) { m_fileStream.read(buffer, size); return (size_t)m_fileStream.gcount(); }
+
 	std::string ReadLine(bool trim = true)
 	{
 		std::string line;
@@ -0,0 +1,152 @@
+#include "GridSearch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <intrin.h>
+
+#include "Bit.h"
+
+static constexpr uint32_t GRID_LANES = 16;
+static constexpr char GRID_PADDING = '\0'; // Never matches a template cell, so borders need no bounds checks.
+
+void GridSearch::AddWord(const char* word)
+{
+	static const int32_t directions[8][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, -1}, {1, -1}, {-1, 1} };
+
+	const int32_t length = (int32_t)strlen(word);
+	assert(length > 0);
+	for (const int32_t* dir : directions)
+	{
+		Template cells;
+		for (int32_t i = 0; i < length; ++i)
+		{
+			cells.push_back({ dir[0] * i, dir[1] * i, word[i] });
+		}
+		m_templates.push_back(cells);
+	}
+}
+
+void GridSearch::AddTemplate(const char* const* rows, uint32_t numRows, bool allRotations)
+{
+	Template cells;
+	for (uint32_t y = 0; y < numRows; ++y)
+	{
+		for (int32_t x = 0; rows[y][x]; ++x)
+		{
+			if (rows[y][x] != '.')
+			{
+				cells.push_back({ x, (int32_t)y, rows[y][x] });
+			}
+		}
+	}
+	assert(!cells.empty());
+
+	for (uint32_t rotation = 0; rotation < (allRotations ? 4U : 1U); ++rotation)
+	{
+		AddCells(cells);
+		for (Cell& cell : cells)
+		{
+			// 90 degrees clockwise.
+			const int32_t dx = cell.dx;
+			cell.dx = -cell.dy;
+			cell.dy = dx;
+		}
+	}
+}
+
+void GridSearch::AddCells(Template cells)
+{
+	// Sort into a canonical order (row major, relative to the top left cell) to spot duplicate rotations, then rebase on
+	// the first cell.
+	std::sort(cells.begin(), cells.end(), [](const Cell& a, const Cell& b) { return a.dy != b.dy ? a.dy < b.dy : a.dx < b.dx; });
+	const Cell first = cells[0];
+	for (Cell& cell : cells)
+	{
+		cell.dx -= first.dx;
+		cell.dy -= first.dy;
+	}
+
+	for (const Template& existing : m_templates)
+	{
+		if (existing.size() == cells.size() && std::equal(existing.begin(), existing.end(), cells.begin(),
+			[](const Cell& a, const Cell& b) { return a.dx == b.dx && a.dy == b.dy && a.value == b.value; }))
+		{
+			return;
+		}
+	}
+
+	m_templates.push_back(cells);
+}
+
+uint64_t GridSearch::CountMatches(const char* cells, uint32_t width, uint32_t height) const
+{
+	if (m_templates.empty() || width == 0 || height == 0)
+	{
+		return 0;
+	}
+
+	int32_t reach = 0;
+	for (const Template& cellTemplate : m_templates)
+	{
+		for (const Cell& cell : cellTemplate)
+		{
+			reach = std::max(reach, std::max(std::abs(cell.dx), std::abs(cell.dy)));
+		}
+	}
+
+	// Copy into a buffer padded on every side, wide enough that a 16 byte load at any shifted offset stays inside it.
+	const size_t padX = (size_t)reach + GRID_LANES;
+	const size_t padY = (size_t)reach;
+	const size_t stride = width + 2 * padX;
+	std::vector<char> padded(stride * (height + 2 * padY), GRID_PADDING);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		memcpy(&padded[(y + padY) * stride + padX], cells + (size_t)y * width, width);
+	}
+
+	// Flatten each template into byte offsets and broadcast values once, up front.
+	struct FlatCell
+	{
+		ptrdiff_t offset;
+		__m128i value;
+	};
+	std::vector<FlatCell> flatCells;
+	std::vector<size_t> templateEnds;
+	for (const Template& cellTemplate : m_templates)
+	{
+		for (const Cell& cell : cellTemplate)
+		{
+			flatCells.push_back({ (ptrdiff_t)cell.dy * (ptrdiff_t)stride + cell.dx, _mm_set1_epi8(cell.value) });
+		}
+		templateEnds.push_back(flatCells.size());
+	}
+
+	uint64_t matches = 0;
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		const char* row = &padded[(y + padY) * stride + padX];
+		for (uint32_t x = 0; x < width; x += GRID_LANES)
+		{
+			const char* origin = row + x;
+			const uint32_t laneMask = Bits::CreateBitMask(0, std::min(GRID_LANES, width - x));
+
+			size_t cellIndex = 0;
+			for (size_t templateEnd : templateEnds)
+			{
+				uint32_t mask = laneMask;
+				for (; cellIndex < templateEnd && mask; ++cellIndex)
+				{
+					const __m128i bytes = _mm_loadu_si128((const __m128i*)(origin + flatCells[cellIndex].offset));
+					mask &= (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, flatCells[cellIndex].value));
+				}
+				cellIndex = templateEnd;
+				matches += Bits::PopCount32(mask);
+			}
+		}
+	}
+
+	return matches;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Counts placements of small character templates in a 2D grid of bytes, 16 columns at a time with SSE compares against
+// shifted rows. Each template is a set of (dx, dy, char) cells, matched wherever every cell lines up with the grid.
+//
+// GridSearch search;
+// search.AddWord("XMAS");                                  // All 8 directions.
+// const char* crossRows[] = { "M.S", ".A.", "M.S" };
+// search.AddTemplate(crossRows, 3, true);                  // '.' is a wildcard, rotations included.
+// uint64_t matches = search.CountMatches(grid, width, height);
+class GridSearch
+{
+public:
+	// Adds the word read in each of the 8 directions. Palindromes are counted once per direction, same as the puzzle.
+	void AddWord(const char* word);
+
+	// Adds a rectangular template, one string per row with '.' as a wildcard. With allRotations the 90/180/270 degree
+	// rotations are added too, skipping any that are identical to one already added.
+	void AddTemplate(const char* const* rows, uint32_t numRows, bool allRotations = false);
+
+	void Clear() { m_templates.clear(); }
+
+	// Total matches of every template. Cells are width * height bytes, row major with no separators.
+	uint64_t CountMatches(const char* cells, uint32_t width, uint32_t height) const;
+
+private:
+	struct Cell
+	{
+		int32_t dx;
+		int32_t dy;
+		char value;
+	};
+
+	// Cells relative to the first one, so every full match has its first cell inside the grid.
+	typedef std::vector<Cell> Template;
+
+	void AddCells(Template cells);
+
+	std::vector<Template> m_templates;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <intrin.h>
+
+// Unsigned 128 bit integer for counts and products that outgrow 64 bits. Arithmetic wraps modulo 2^128 like the
+// built in unsigned types, so signed values can ride along in two's complement (FromSigned / IsNegative).
+struct UInt128
+{
+public:
+	constexpr UInt128() : low(0), high(0) {}
+	constexpr UInt128(uint64_t _low) : low(_low), high(0) {}
+	constexpr UInt128(uint64_t _low, uint64_t _high) : low(_low), high(_high) {}
+
+	static UInt128 Multiply(uint64_t a, uint64_t b)
+	{
+		UInt128 result;
+		result.low = _umul128(a, b, &result.high);
+		return result;
+	}
+
+	static UInt128 FromSigned(int64_t value)
+	{
+		return UInt128((uint64_t)value, value < 0 ? ~0ULL : 0);
+	}
+
+	// Quotient and remainder by shift and subtract, divisor must be non zero. Not quick, keep it off hot paths.
+	static UInt128 DivMod(const UInt128& numerator, const UInt128& divisor, UInt128* outRemainder = nullptr)
+	{
+		assert(!divisor.IsZero());
+		UInt128 quotient;
+		UInt128 remainder;
+		for (int bit = 127; bit >= 0; --bit)
+		{
+			const uint64_t nextBit = bit >= 64 ? (numerator.high >> (bit - 64)) & 1 : (numerator.low >> bit) & 1;
+			remainder = UInt128((remainder.low << 1) | nextBit, (remainder.high << 1) | (remainder.low >> 63));
+			if (!(remainder < divisor))
+			{
+				remainder -= divisor;
+				if (bit >= 64)
+				{
+					quotient.high |= 1ULL << (bit - 64);
+				}
+				else
+				{
+					quotient.low |= 1ULL << bit;
+				}
+			}
+		}
+
+		if (outRemainder)
+		{
+			*outRemainder = remainder;
+		}
+		return quotient;
+	}
+
+	bool IsZero() const { return low == 0 && high == 0; }
+	bool FitsIn64() const { return high == 0; }
+	bool IsNegative() const { return (high >> 63) != 0; } // Read as two's complement.
+	UInt128 Negated() const { return UInt128() - *this; }
+
+	UInt128 operator+(const UInt128& RHS) const
+	{
+		const uint64_t sumLow = low + RHS.low;
+		return UInt128(sumLow, high + RHS.high + (sumLow < low ? 1 : 0));
+	}
+
+	UInt128& operator+=(const UInt128& RHS)
+	{
+		*this = *this + RHS;
+		return *this;
+	}
+
+	UInt128 operator-(const UInt128& RHS) const
+	{
+		return UInt128(low - RHS.low, high - RHS.high - (low < RHS.low ? 1 : 0));
+	}
+
+	UInt128& operator-=(const UInt128& RHS)
+	{
+		*this = *this - RHS;
+		return *this;
+	}
+
+	UInt128 operator*(const UInt128& RHS) const
+	{
+		UInt128 result = Multiply(low, RHS.low);
+		result.high += low * RHS.high + high * RHS.low;
+		return result;
+	}
+
+	UInt128& operator*=(const UInt128& RHS)
+	{
+		*this = *this * RHS;
+		return *this;
+	}
+
+	bool operator==(const UInt128& RHS) const { return low == RHS.low && high == RHS.high; }
+	bool operator!=(const UInt128& RHS) const { return !(*this == RHS); }
+	bool operator<(const UInt128& RHS) const { return high != RHS.high ? high < RHS.high : low < RHS.low; }
+
+	// Divides in place by a 32 bit divisor, returning the remainder.
+	uint32_t DivMod32(uint32_t divisor)
+	{
+		uint64_t remainder = 0;
+		uint32_t limbs[4] = { (uint32_t)(high >> 32), (uint32_t)high, (uint32_t)(low >> 32), (uint32_t)low };
+		for (uint32_t& limb : limbs)
+		{
+			const uint64_t current = (remainder << 32) | limb;
+			limb = (uint32_t)(current / divisor);
+			remainder = current % divisor;
+		}
+
+		high = ((uint64_t)limbs[0] << 32) | limbs[1];
+		low = ((uint64_t)limbs[2] << 32) | limbs[3];
+		return (uint32_t)remainder;
+	}
+
+	// Decimal representation, for logging. Needs at most 40 bytes.
+	const char* ToString(char* buffer, size_t bufferSize) const
+	{
+		char digits[40];
+		size_t numDigits = 0;
+		UInt128 value = *this;
+		do
+		{
+			digits[numDigits++] = (char)('0' + value.DivMod32(10));
+		} while (!value.IsZero());
+
+		size_t i = 0;
+		for (; i < numDigits && i + 1 < bufferSize; ++i)
+		{
+			buffer[i] = digits[numDigits - 1 - i];
+		}
+		buffer[i] = '\0';
+		return buffer;
+	}
+
+	uint64_t low;
+	uint64_t high;
+};
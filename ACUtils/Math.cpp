@@ -48,6 +48,11 @@ int32_t Math::RoundToInt32(float f)
 	return (int32_t)((fabs(f) + 0.5f) * (f < 0.0f ? -1.0f : 1.0f));
 }
 
+// Every power of ten that fits in 64 bits.
+static const uint64_t s_pow10_64[] = { 1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+	1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+	10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL };
+
 uint32_t Math::Log10(uint32_t v)
 {
 	static uint32_t pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
@@ -57,9 +62,19 @@ uint32_t Math::Log10(uint32_t v)
 
 uint32_t Math::Log10(uint64_t v)
 {
-	static uint64_t pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000, 10000000000, 100000000000, 1000000000000 };
 	uint32_t tmp = (FloorLog2_64(v) + 1) * 1233ULL >> 12U;
-	return tmp - (v < pow10[tmp]);
+	return tmp - (v < s_pow10_64[tmp]);
+}
+
+uint64_t Math::Pow10(uint32_t exponent)
+{
+	assert(exponent < ARRAY_SIZE(s_pow10_64));
+	return s_pow10_64[exponent];
+}
+
+uint32_t Math::CountDigits(uint64_t v)
+{
+	return v == 0 ? 1 : Log10(v) + 1;
 }
 
 uint64_t Math::LCM(uint64_t a, uint64_t b)
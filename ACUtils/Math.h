@@ -49,6 +49,8 @@ namespace Math
 
 	uint32_t Log10(uint32_t v);
 	uint32_t Log10(uint64_t v);
+	uint64_t Pow10(uint32_t exponent); // Table lookup, exponent <= 19.
+	uint32_t CountDigits(uint64_t v);  // Decimal digits, 0 has one.
 
 	// Pow
 	constexpr uint32_t Pow(const uint32_t base, uint32_t pow)
@@ -0,0 +1,122 @@
+#include "Memory.h"
+
+#include <cstdlib>
+#include <new>
+
+Memory::AllocationTracker& Memory::AllocationTracker::Get()
+{
+	// Constant initialized, so it's safe to use from operator new before any static constructors have run.
+	static AllocationTracker s_Instance;
+	return s_Instance;
+}
+
+void Memory::AllocationTracker::RecordAlloc(size_t size)
+{
+	m_allocCount.fetch_add(1, std::memory_order_relaxed);
+	m_bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+	uint64_t live = m_liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+
+	AtomicMax(m_peakLiveHeapBytes, live);
+	AtomicMax(m_largestAlloc, size);
+}
+
+void Memory::AllocationTracker::RecordFree(size_t size)
+{
+	m_freeCount.fetch_add(1, std::memory_order_relaxed);
+	m_liveBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+void Memory::AllocationTracker::RecordArenaAlloc(size_t size)
+{
+	m_arenaAllocCount.fetch_add(1, std::memory_order_relaxed);
+	m_arenaBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void Memory::AllocationTracker::BeginPhase()
+{
+	m_phaseStart.allocCount = m_allocCount.load(std::memory_order_relaxed);
+	m_phaseStart.freeCount = m_freeCount.load(std::memory_order_relaxed);
+	m_phaseStart.bytesAllocated = m_bytesAllocated.load(std::memory_order_relaxed);
+	m_phaseStart.arenaAllocCount = m_arenaAllocCount.load(std::memory_order_relaxed);
+	m_phaseStart.arenaBytes = m_arenaBytes.load(std::memory_order_relaxed);
+
+	// High water marks restart from whatever is live right now.
+	m_peakLiveHeapBytes.store(m_liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	m_largestAlloc.store(0, std::memory_order_relaxed);
+}
+
+Memory::AllocationStats Memory::AllocationTracker::EndPhase() const
+{
+	AllocationStats stats;
+	stats.allocCount = m_allocCount.load(std::memory_order_relaxed) - m_phaseStart.allocCount;
+	stats.freeCount = m_freeCount.load(std::memory_order_relaxed) - m_phaseStart.freeCount;
+	stats.bytesAllocated = m_bytesAllocated.load(std::memory_order_relaxed) - m_phaseStart.bytesAllocated;
+	stats.peakLiveHeapBytes = m_peakLiveHeapBytes.load(std::memory_order_relaxed);
+	stats.largestAlloc = m_largestAlloc.load(std::memory_order_relaxed);
+	stats.arenaAllocCount = m_arenaAllocCount.load(std::memory_order_relaxed) - m_phaseStart.arenaAllocCount;
+	stats.arenaBytes = m_arenaBytes.load(std::memory_order_relaxed) - m_phaseStart.arenaBytes;
+	return stats;
+}
+
+#if AC_MEMORY_TRACKING
+
+// Every tracked block is prefixed with its requested size so delete can report it.
+// 16 bytes keeps the user pointer at malloc's natural alignment.
+static constexpr size_t TRACKED_HEADER_SIZE = 16;
+
+static void* TrackedAlloc(size_t size)
+{
+	char* block = (char*)malloc(size + TRACKED_HEADER_SIZE);
+	if (!block)
+	{
+		return nullptr;
+	}
+
+	*(size_t*)block = size;
+	Memory::AllocationTracker::Get().RecordAlloc(size);
+	return block + TRACKED_HEADER_SIZE;
+}
+
+static void TrackedFree(void* ptr)
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	char* block = (char*)ptr - TRACKED_HEADER_SIZE;
+	Memory::AllocationTracker::Get().RecordFree(*(size_t*)block);
+	free(block);
+}
+
+void* operator new(size_t size)
+{
+	void* ptr = TrackedAlloc(size);
+	if (!ptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	void* ptr = TrackedAlloc(size);
+	if (!ptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return TrackedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return TrackedAlloc(size); }
+
+void operator delete(void* ptr) noexcept { TrackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { TrackedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { TrackedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { TrackedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { TrackedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { TrackedFree(ptr); }
+
+#endif // AC_MEMORY_TRACKING
@@ -5,8 +5,74 @@
 #include <atomic>
 #include <memory>
 
+// Set AC_MEMORY_TRACKING to 1 in the project's preprocessor definitions to replace the global operator new/delete
+// and record allocation counts, sizes and high water marks. Off by default, in which case the tracker is never touched.
+#if !defined(AC_MEMORY_TRACKING)
+#define AC_MEMORY_TRACKING 0
+#endif
+
 namespace Memory
 {
+	struct AllocationStats
+	{
+		uint64_t allocCount = 0;        // Heap allocations made.
+		uint64_t freeCount = 0;         // Heap allocations released.
+		uint64_t bytesAllocated = 0;    // Total heap bytes requested.
+		uint64_t peakLiveHeapBytes = 0; // High water mark of live tracked heap bytes. Not the process's resident memory.
+		uint64_t largestAlloc = 0;      // Largest single heap allocation.
+		uint64_t arenaAllocCount = 0;   // Allocations served by a LinearAllocator / Ringbuffer.
+		uint64_t arenaBytes = 0;        // Bytes served by a LinearAllocator / Ringbuffer.
+	};
+
+	// Thread safe global allocation counters. Fed by the operator new/delete replacements in Memory.cpp and the arenas below.
+	// Stats are gathered per phase: BeginPhase() resets the high water marks, EndPhase() returns everything since BeginPhase().
+	class AllocationTracker
+	{
+	public:
+		static AllocationTracker& Get();
+
+		static constexpr bool IsEnabled() { return AC_MEMORY_TRACKING != 0; }
+
+		void RecordAlloc(size_t size);
+		void RecordFree(size_t size);
+		void RecordArenaAlloc(size_t size);
+
+		void BeginPhase();
+		AllocationStats EndPhase() const;
+
+		uint64_t GetLiveBytes() const { return m_liveBytes.load(std::memory_order_relaxed); }
+	private:
+		constexpr AllocationTracker()
+		: m_allocCount(0ULL),
+		m_freeCount(0ULL),
+		m_bytesAllocated(0ULL),
+		m_liveBytes(0ULL),
+		m_peakLiveHeapBytes(0ULL),
+		m_largestAlloc(0ULL),
+		m_arenaAllocCount(0ULL),
+		m_arenaBytes(0ULL),
+		m_phaseStart()
+		{
+		}
+
+		static void AtomicMax(std::atomic<uint64_t>& target, uint64_t value)
+		{
+			uint64_t current = target.load(std::memory_order_relaxed);
+			while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		std::atomic<uint64_t> m_allocCount;
+		std::atomic<uint64_t> m_freeCount;
+		std::atomic<uint64_t> m_bytesAllocated;
+		std::atomic<uint64_t> m_liveBytes;
+		std::atomic<uint64_t> m_peakLiveHeapBytes;
+		std::atomic<uint64_t> m_largestAlloc;
+		std::atomic<uint64_t> m_arenaAllocCount;
+		std::atomic<uint64_t> m_arenaBytes;
+		AllocationStats m_phaseStart; // Counter snapshot taken by BeginPhase.
+	};
 
 	// Thread safe linear allocator.
 	// Just keeps allocating and asserts when it runs out.
@@ -56,6 +122,9 @@ namespace Memory
 		// Malloc style allocator
 		void* Alloc(size_t size)
 		{
+#if AC_MEMORY_TRACKING
+			AllocationTracker::Get().RecordArenaAlloc(size);
+#endif
 			assert((m_offset.load(std::memory_order_acquire) + size) < m_totalSize);
 			return m_memory + m_offset.fetch_add(size, std::memory_order_release);
 		}
@@ -122,6 +191,9 @@ namespace Memory
 		// Malloc style allocator
 		void* Alloc(size_t size)
 		{
+#if AC_MEMORY_TRACKING
+			AllocationTracker::Get().RecordArenaAlloc(size);
+#endif
 			assert(size < m_totalSize);
 			if (m_offset.load(std::memory_order_acquire) + size >= m_totalSize)
 			{
@@ -148,4 +220,217 @@ namespace Memory
 		OnWrapAroundFunc m_wrapCallback;
 	};
 
+	// Lock free single producer / single consumer ring of variable sized records.
+	// One thread reserves and commits records, one (other) thread peeks and pops them. Records never straddle the end of the
+	// buffer; if one doesn't fit the producer writes a padding record and wraps to the front.
+	class SPSCRingbuffer
+	{
+	public:
+		SPSCRingbuffer(size_t sizeInBytes)
+		: m_memory(nullptr),
+		m_totalSize(sizeInBytes),
+		m_head(0ULL),
+		m_reserved(0ULL),
+		m_tail(0ULL)
+		{
+			assert((sizeInBytes & (sizeInBytes - 1)) == 0); // Must be a power of two.
+			m_memory = (char*)malloc(m_totalSize);
+			assert(m_memory);
+		}
+
+		~SPSCRingbuffer()
+		{
+			assert(m_memory);
+			free(m_memory);
+			m_memory = nullptr;
+		}
+
+		// Producer. Returns nullptr if the consumer hasn't freed enough space yet.
+		void* Reserve(size_t size)
+		{
+			assert(m_reserved == 0); // Commit the previous record first.
+			const uint64_t recordSize = AlignRecord(size + sizeof(RecordHeader));
+			assert(recordSize <= m_totalSize);
+
+			const uint64_t head = m_head.load(std::memory_order_relaxed);
+			const uint64_t tail = m_tail.load(std::memory_order_acquire);
+			const uint64_t offset = head & (m_totalSize - 1);
+			const uint64_t padding = (offset + recordSize > m_totalSize) ? m_totalSize - offset : 0;
+
+			if (m_totalSize - (head - tail) < padding + recordSize)
+			{
+				return nullptr;
+			}
+
+			if (padding)
+			{
+				RecordHeader* pad = (RecordHeader*)(m_memory + offset);
+				pad->size = (uint32_t)padding;
+				pad->isPadding = 1;
+			}
+
+			RecordHeader* header = (RecordHeader*)(m_memory + ((head + padding) & (m_totalSize - 1)));
+			header->size = (uint32_t)recordSize;
+			header->isPadding = 0;
+			m_reserved = padding + recordSize;
+			return header + 1;
+		}
+
+		// Producer. Publishes the last reserved record to the consumer.
+		void Commit()
+		{
+			m_head.store(m_head.load(std::memory_order_relaxed) + m_reserved, std::memory_order_release);
+			m_reserved = 0;
+		}
+
+		// Consumer. Returns the oldest committed record, or nullptr if there isn't one.
+		const void* Peek()
+		{
+			uint64_t tail = m_tail.load(std::memory_order_relaxed);
+			const uint64_t head = m_head.load(std::memory_order_acquire);
+			while (tail != head)
+			{
+				const RecordHeader* header = (const RecordHeader*)(m_memory + (tail & (m_totalSize - 1)));
+				if (!header->isPadding)
+				{
+					return header + 1;
+				}
+
+				tail += header->size;
+				m_tail.store(tail, std::memory_order_release);
+			}
+
+			return nullptr;
+		}
+
+		// Consumer. Releases the record returned by Peek.
+		void Pop()
+		{
+			const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+			const RecordHeader* header = (const RecordHeader*)(m_memory + (tail & (m_totalSize - 1)));
+			m_tail.store(tail + header->size, std::memory_order_release);
+		}
+
+		bool IsEmpty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+	private:
+		struct RecordHeader
+		{
+			uint32_t size;
+			uint32_t isPadding;
+		};
+
+		static constexpr uint64_t AlignRecord(uint64_t size) { return (size + 7ULL) & ~7ULL; }
+
+		char* m_memory;
+		size_t m_totalSize;
+		std::atomic<uint64_t> m_head; // Written by the producer.
+		uint64_t m_reserved;          // Producer only, size of the uncommitted record (plus padding).
+		char m_cacheLinePad[64];      // Keep the producer and consumer sides off the same cache line.
+		std::atomic<uint64_t> m_tail; // Written by the consumer.
+	};
+
+	// Hands each thread that asks its own SPSCRingbuffer, so one consumer can drain every thread's records without locks.
+	// Rings outlive their threads (so they can still be drained); a ring released by an exited thread is reused by the next
+	// thread that registers. The thread_local is per Tag, so use one registry per Tag.
+	template<typename Tag, uint32_t MAX_THREADS = 64>
+	class ThreadRingRegistry
+	{
+	public:
+		ThreadRingRegistry(size_t ringSizeInBytes)
+		: m_ringSize(ringSizeInBytes),
+		m_numRings(0)
+		{
+			for (uint32_t i = 0; i < MAX_THREADS; ++i)
+			{
+				m_slots[i].ring.store(nullptr, std::memory_order_relaxed);
+				m_slots[i].owned.store(false, std::memory_order_relaxed);
+			}
+		}
+
+		~ThreadRingRegistry()
+		{
+			for (uint32_t i = 0; i < MAX_THREADS; ++i)
+			{
+				delete m_slots[i].ring.load(std::memory_order_acquire);
+			}
+		}
+
+		// Producer side. Returns nullptr if MAX_THREADS threads already own a ring.
+		SPSCRingbuffer* GetThreadRing(uint32_t* outIndex = nullptr)
+		{
+			static thread_local SlotOwnership t_ownership;
+			if (!t_ownership.slot)
+			{
+				t_ownership.slot = ClaimSlot();
+				if (!t_ownership.slot)
+				{
+					return nullptr;
+				}
+			}
+
+			if (outIndex)
+			{
+				*outIndex = (uint32_t)(t_ownership.slot - m_slots);
+			}
+			return t_ownership.slot->ring.load(std::memory_order_relaxed);
+		}
+
+		// Consumer side. Rings may be null while a thread is still registering.
+		uint32_t GetNumRings() const
+		{
+			const uint32_t numRings = m_numRings.load(std::memory_order_acquire);
+			return numRings < MAX_THREADS ? numRings : MAX_THREADS;
+		}
+
+		SPSCRingbuffer* GetRing(uint32_t index) const { return m_slots[index].ring.load(std::memory_order_acquire); }
+	private:
+		struct Slot
+		{
+			std::atomic<SPSCRingbuffer*> ring;
+			std::atomic<bool> owned;
+		};
+
+		// Gives the slot back when the owning thread exits.
+		struct SlotOwnership
+		{
+			Slot* slot = nullptr;
+			~SlotOwnership()
+			{
+				if (slot)
+				{
+					slot->owned.store(false, std::memory_order_release);
+				}
+			}
+		};
+
+		Slot* ClaimSlot()
+		{
+			// Reuse a ring abandoned by an exited thread first.
+			const uint32_t numRings = GetNumRings();
+			for (uint32_t i = 0; i < numRings; ++i)
+			{
+				bool expected = false;
+				if (m_slots[i].ring.load(std::memory_order_acquire) && m_slots[i].owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+				{
+					return &m_slots[i];
+				}
+			}
+
+			const uint32_t index = m_numRings.fetch_add(1, std::memory_order_acq_rel);
+			if (index >= MAX_THREADS)
+			{
+				assert(false); // Too many live producer threads.
+				return nullptr;
+			}
+
+			m_slots[index].owned.store(true, std::memory_order_relaxed);
+			m_slots[index].ring.store(new SPSCRingbuffer(m_ringSize), std::memory_order_release);
+			return &m_slots[index];
+		}
+
+		Slot m_slots[MAX_THREADS];
+		size_t m_ringSize;
+		std::atomic<uint32_t> m_numRings;
+	};
+
 }
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Minimal fork/join helpers on top of std::thread. Threads are spawned per call, so keep the work coarse (anything that
+// takes milliseconds is fine). The calling thread always takes part as thread index 0.
+namespace Parallel
+{
+	inline uint32_t GetNumThreads()
+	{
+		static const uint32_t s_numThreads = std::max(std::thread::hardware_concurrency(), 1U);
+		return s_numThreads;
+	}
+
+	// Calls func(threadIndex, begin, end) over [0, count) in chunks of grainSize, handed out dynamically so uneven work
+	// balances itself. threadIndex is below GetNumThreads(), use it to pick per thread scratch/results.
+	template<typename Func>
+	void For(size_t count, size_t grainSize, Func&& func)
+	{
+		grainSize = std::max<size_t>(grainSize, 1);
+		const size_t numChunks = (count + grainSize - 1) / grainSize;
+		const uint32_t numThreads = (uint32_t)std::min<size_t>(GetNumThreads(), numChunks);
+		if (numThreads <= 1)
+		{
+			if (count)
+			{
+				func(0U, (size_t)0, count);
+			}
+			return;
+		}
+
+		std::atomic<size_t> nextChunk(0);
+		auto worker = [&](uint32_t threadIndex)
+		{
+			for (size_t chunk = nextChunk.fetch_add(1); chunk < numChunks; chunk = nextChunk.fetch_add(1))
+			{
+				const size_t begin = chunk * grainSize;
+				func(threadIndex, begin, std::min(begin + grainSize, count));
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads - 1);
+		for (uint32_t i = 1; i < numThreads; ++i)
+		{
+			threads.emplace_back(worker, i);
+		}
+		worker(0);
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
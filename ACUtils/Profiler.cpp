@@ -0,0 +1,131 @@
+#include "Profiler.h"
+
+#include "Memory.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+namespace Profiler
+{
+	static constexpr size_t THREAD_RING_SIZE = 4 * 1024 * 1024;
+	static constexpr size_t MAX_COLLECTED_EVENTS = 4 * 1024 * 1024; // Stop collecting once the history gets this big.
+
+	struct RecordedEvent
+	{
+		const char* name;
+		uint64_t startNs;
+		uint64_t endNs;
+		uint32_t depth;
+	};
+
+	static Memory::ThreadRingRegistry<RecordedEvent>& GetRings()
+	{
+		static Memory::ThreadRingRegistry<RecordedEvent> s_rings(THREAD_RING_SIZE);
+		return s_rings;
+	}
+
+	static std::vector<Event> s_events;
+	static std::atomic<uint64_t> s_dropped(0ULL);
+	static thread_local uint32_t t_depth = 0;
+}
+
+uint64_t Profiler::GetTimestampNs()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t Profiler::PushScope()
+{
+	return t_depth++;
+}
+
+void Profiler::PopScope(const char* name, uint64_t startNs, uint32_t depth)
+{
+	const uint64_t endNs = GetTimestampNs();
+	--t_depth;
+
+	Memory::SPSCRingbuffer* ring = GetRings().GetThreadRing();
+	RecordedEvent* event = ring ? (RecordedEvent*)ring->Reserve(sizeof(RecordedEvent)) : nullptr;
+	if (!event)
+	{
+		s_dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	event->name = name;
+	event->startNs = startNs;
+	event->endNs = endNs;
+	event->depth = depth;
+	ring->Commit();
+}
+
+void Profiler::Collect()
+{
+	Memory::ThreadRingRegistry<RecordedEvent>& rings = GetRings();
+	const uint32_t numRings = rings.GetNumRings();
+	for (uint32_t i = 0; i < numRings; ++i)
+	{
+		Memory::SPSCRingbuffer* ring = rings.GetRing(i);
+		if (!ring)
+		{
+			continue;
+		}
+
+		while (const RecordedEvent* recorded = (const RecordedEvent*)ring->Peek())
+		{
+			if (s_events.size() < MAX_COLLECTED_EVENTS)
+			{
+				s_events.push_back({ recorded->name, recorded->startNs, recorded->endNs, recorded->depth, i });
+			}
+			else
+			{
+				s_dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+			ring->Pop();
+		}
+	}
+}
+
+const std::vector<Profiler::Event>& Profiler::GetEvents()
+{
+	return s_events;
+}
+
+void Profiler::ClearEvents()
+{
+	s_events.clear();
+}
+
+uint64_t Profiler::GetDroppedCount()
+{
+	return s_dropped.load(std::memory_order_relaxed);
+}
+
+bool Profiler::WriteChromeTrace(const char* filename)
+{
+	FILE* traceFile = nullptr;
+	if (fopen_s(&traceFile, filename, "w") != 0 || !traceFile)
+	{
+		return false;
+	}
+
+	uint64_t baseNs = ~0ULL;
+	for (const Event& event : s_events)
+	{
+		baseNs = event.startNs < baseNs ? event.startNs : baseNs;
+	}
+
+	// Complete ("X") events, timestamps and durations in microseconds.
+	fprintf(traceFile, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for (size_t i = 0; i < s_events.size(); ++i)
+	{
+		const Event& event = s_events[i];
+		fprintf(traceFile, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+			event.name, event.threadIndex, (double)(event.startNs - baseNs) / 1000.0, (double)(event.endNs - event.startNs) / 1000.0,
+			i + 1 < s_events.size() ? "," : "");
+	}
+	fprintf(traceFile, "]}\n");
+	fclose(traceFile);
+	return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Instrumentation profiler. Set AC_PROFILING to 1 in the project's preprocessor definitions to compile the scopes in,
+// otherwise AC_PROFILE_SCOPE expands to nothing.
+//
+// void Solve()
+// {
+//     AC_PROFILE_SCOPE("Solve"); // name must be a string literal, only the pointer is recorded.
+//     ...
+// }
+#if !defined(AC_PROFILING)
+#define AC_PROFILING 0
+#endif
+
+#define AC_PROFILE_CONCAT_INNER(a, b) a##b
+#define AC_PROFILE_CONCAT(a, b) AC_PROFILE_CONCAT_INNER(a, b)
+
+#if AC_PROFILING
+#define AC_PROFILE_SCOPE(name) Profiler::ScopedEvent AC_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#else
+#define AC_PROFILE_SCOPE(name) do { } while (0)
+#endif
+
+namespace Profiler
+{
+	struct Event
+	{
+		const char* name;
+		uint64_t startNs;
+		uint64_t endNs;
+		uint32_t depth;       // Nesting depth on the recording thread.
+		uint32_t threadIndex; // Index of the recording thread's ring.
+	};
+
+	uint64_t GetTimestampNs();
+
+	// Producer side, any thread. Events are written to a lock free ring owned by the calling thread.
+	uint32_t PushScope();
+	void PopScope(const char* name, uint64_t startNs, uint32_t depth);
+
+	class ScopedEvent
+	{
+	public:
+		ScopedEvent(const char* name)
+		: m_name(name),
+		m_depth(PushScope()),
+		m_startNs(GetTimestampNs())
+		{
+		}
+
+		~ScopedEvent()
+		{
+			PopScope(m_name, m_startNs, m_depth);
+		}
+	private:
+		const char* m_name;
+		uint32_t m_depth;
+		uint64_t m_startNs;
+	};
+
+	// Consumer side, one thread only. Collect moves everything recorded so far into the event history.
+	void Collect();
+	const std::vector<Event>& GetEvents();
+	void ClearEvents();
+	uint64_t GetDroppedCount();
+
+	// Writes the event history in the Chrome trace event format (chrome://tracing, Perfetto, Speedscope).
+	bool WriteChromeTrace(const char* filename);
+}
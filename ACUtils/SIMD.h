@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <intrin.h>
+
+// SSE4.1 kernels. Every x64 CPU we care about has it, so there's no scalar-only fallback path, just the scalar tails.
+namespace SIMD
+{
+	// Sum of |a[i] - b[i]|. Accumulates in 64 bits so large inputs can't overflow.
+	inline uint64_t SumAbsoluteDifferences(const int32_t* a, const int32_t* b, size_t count)
+	{
+		__m128i sum = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+			const __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+			// max - min is the absolute difference, and can't overflow as an unsigned 32 bit value.
+			const __m128i diff = _mm_sub_epi32(_mm_max_epi32(va, vb), _mm_min_epi32(va, vb));
+			sum = _mm_add_epi64(sum, _mm_cvtepu32_epi64(diff));
+			sum = _mm_add_epi64(sum, _mm_cvtepu32_epi64(_mm_srli_si128(diff, 8)));
+		}
+
+		uint64_t total = (uint64_t)_mm_cvtsi128_si64(sum) + (uint64_t)_mm_extract_epi64(sum, 1);
+		for (; i < count; ++i)
+		{
+			total += a[i] > b[i] ? (uint64_t)((uint32_t)a[i] - (uint32_t)b[i]) : (uint64_t)((uint32_t)b[i] - (uint32_t)a[i]);
+		}
+
+		return total;
+	}
+
+	// Pointer to the first byte in [data, end) equal to any of the needles, or end. Up to 4 needles, memchr style.
+	inline const char* FindFirstOf(const char* data, const char* end, const uint8_t* needles, uint32_t numNeedles)
+	{
+		__m128i needleVecs[4];
+		for (uint32_t n = 0; n < numNeedles; ++n)
+		{
+			needleVecs[n] = _mm_set1_epi8((char)needles[n]);
+		}
+
+		for (; data + 16 <= end; data += 16)
+		{
+			const __m128i bytes = _mm_loadu_si128((const __m128i*)data);
+			__m128i hits = _mm_setzero_si128();
+			for (uint32_t n = 0; n < numNeedles; ++n)
+			{
+				hits = _mm_or_si128(hits, _mm_cmpeq_epi8(bytes, needleVecs[n]));
+			}
+
+			const uint32_t mask = (uint32_t)_mm_movemask_epi8(hits);
+			if (mask)
+			{
+				return data + _tzcnt_u32(mask);
+			}
+		}
+
+		for (; data < end; ++data)
+		{
+			for (uint32_t n = 0; n < numNeedles; ++n)
+			{
+				if ((uint8_t)*data == needles[n])
+				{
+					return data;
+				}
+			}
+		}
+
+		return end;
+	}
+}
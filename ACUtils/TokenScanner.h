@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "SIMD.h"
+
+// Table driven DFA that pulls fixed shape tokens out of a byte stream, e.g. "mul(#,#)" where '#' is a run of 1 to maxDigits
+// decimal digits captured as an argument. Scanner state survives between Scan calls, so input can be fed in chunks of any
+// size and tokens are still found when they straddle a chunk (or line) boundary.
+//
+// TokenScanner scanner;
+// scanner.AddToken(0, "mul(#,#)");
+// scanner.AddToken(1, "do()");
+// scanner.Scan(data, size, [](const TokenScanner::Token& token) { ... });
+//
+// A pattern's first byte may not appear anywhere else in any pattern. That lets a failed match restart from the byte that
+// broke it without any failure links, and means the start state can skip straight to the next start byte with SIMD.
+class TokenScanner
+{
+public:
+	static constexpr uint32_t MAX_ARGS = 4;
+	static constexpr uint32_t MAX_START_BYTES = 4;
+
+	struct Token
+	{
+		uint32_t id;
+		uint32_t numArgs;
+		int64_t args[MAX_ARGS];
+	};
+
+	TokenScanner(uint32_t maxDigits = 3)
+	: m_maxDigits(maxDigits),
+	m_numStartBytes(0),
+	m_state(START_STATE),
+	m_value(0),
+	m_current()
+	{
+		assert(maxDigits > 0 && maxDigits <= 18);
+		AddState(ACTION_NONE);
+	}
+
+	void AddToken(uint32_t id, const char* pattern)
+	{
+		assert(pattern && pattern[0] != '#' && pattern[0] != '\0');
+		const uint8_t startByte = (uint8_t)pattern[0];
+		if (!IsStartByte(startByte))
+		{
+			assert(m_numStartBytes < MAX_START_BYTES);
+			m_startBytes[m_numStartBytes++] = startByte;
+		}
+
+		// Build the pattern as a trie, sharing prefixes with the patterns already added. A '#' expands into maxDigits
+		// states chained by digit transitions, every one of which can exit on the byte that follows it.
+		std::vector<uint16_t> tails;
+		tails.push_back(START_STATE);
+		bool afterNumber = false;
+		uint32_t numArgs = 0;
+		for (const char* cursor = pattern; *cursor; ++cursor)
+		{
+			if (*cursor == '#')
+			{
+				assert(!afterNumber && numArgs < MAX_ARGS);
+				uint16_t from = tails[0];
+				tails.clear();
+				for (uint32_t d = 0; d < m_maxDigits; ++d)
+				{
+					const uint16_t digitState = GetOrAddTransition(from, '0', ACTION_DIGIT);
+					for (uint8_t digit = '1'; digit <= '9'; ++digit)
+					{
+						SetNext(from, digit, digitState);
+					}
+					tails.push_back(digitState);
+					from = digitState;
+				}
+				afterNumber = true;
+				++numArgs;
+				continue;
+			}
+
+			assert(cursor == pattern || !IsStartByte((uint8_t)*cursor));
+			const uint8_t action = (afterNumber ? ACTION_END_ARG : ACTION_NONE) | (cursor == pattern ? ACTION_BEGIN : ACTION_NONE);
+			const uint16_t next = GetOrAddTransition(tails[0], (uint8_t)*cursor, action);
+			for (size_t i = 1; i < tails.size(); ++i)
+			{
+				SetNext(tails[i], (uint8_t)*cursor, next);
+			}
+			tails.clear();
+			tails.push_back(next);
+			afterNumber = false;
+		}
+
+		assert(tails.size() == 1 && tails[0] != START_STATE && !afterNumber);
+		m_actions[tails[0]] |= ACTION_ACCEPT;
+		m_tokenIds[tails[0]] = id;
+	}
+
+	// Feeds the next chunk of input, calling onToken(const Token&) for every token that completes inside it.
+	template<typename Callback>
+	void Scan(const char* data, size_t size, Callback&& onToken)
+	{
+		const char* cursor = data;
+		const char* end = data + size;
+		uint16_t state = m_state;
+		Token& current = m_current;
+		int64_t value = m_value;
+
+		while (cursor < end)
+		{
+			if (state == START_STATE)
+			{
+				cursor = SIMD::FindFirstOf(cursor, end, m_startBytes, m_numStartBytes);
+				if (cursor == end)
+				{
+					break;
+				}
+			}
+
+			const uint8_t byte = (uint8_t)*cursor++;
+			uint16_t next = GetNext(state, byte);
+			if (next == START_STATE && state != START_STATE)
+			{
+				// Failed match, the byte that broke it may start the next token.
+				next = GetNext(START_STATE, byte);
+			}
+			state = next;
+
+			const uint8_t action = m_actions[state];
+			if (action == ACTION_NONE)
+			{
+				continue;
+			}
+
+			if (action & ACTION_BEGIN)
+			{
+				current.numArgs = 0;
+				value = 0;
+			}
+
+			if (action & ACTION_DIGIT)
+			{
+				value = value * 10 + (byte - '0');
+			}
+			else if (action & ACTION_END_ARG)
+			{
+				current.args[current.numArgs++] = value;
+				value = 0;
+			}
+
+			if (action & ACTION_ACCEPT)
+			{
+				current.id = m_tokenIds[state];
+				onToken(current);
+				state = START_STATE;
+			}
+		}
+
+		m_state = state;
+		m_value = value;
+	}
+
+	// Drops any partially matched token, the next Scan starts fresh.
+	void Reset()
+	{
+		m_state = START_STATE;
+		m_value = 0;
+	}
+
+private:
+	enum : uint16_t { START_STATE = 0 };
+
+	enum : uint8_t
+	{
+		ACTION_NONE = 0,
+		ACTION_BEGIN = 1 << 0,   // First byte of a pattern, clear the arguments.
+		ACTION_DIGIT = 1 << 1,   // Append the byte to the argument being parsed.
+		ACTION_END_ARG = 1 << 2, // The byte after a number, store the parsed argument.
+		ACTION_ACCEPT = 1 << 3,  // Last byte of a pattern.
+	};
+
+	bool IsStartByte(uint8_t byte) const
+	{
+		return memchr(m_startBytes, byte, m_numStartBytes) != nullptr;
+	}
+
+	uint16_t GetNext(uint16_t state, uint8_t byte) const
+	{
+		return m_transitions[(size_t)state * 256 + byte];
+	}
+
+	void SetNext(uint16_t state, uint8_t byte, uint16_t next)
+	{
+		m_transitions[(size_t)state * 256 + byte] = next;
+	}
+
+	uint16_t AddState(uint8_t action)
+	{
+		assert(m_actions.size() < 0xFFFF);
+		const uint16_t state = (uint16_t)m_actions.size();
+		m_actions.push_back(action);
+		m_tokenIds.push_back(0);
+		m_transitions.resize(m_transitions.size() + 256, START_STATE);
+		return state;
+	}
+
+	uint16_t GetOrAddTransition(uint16_t state, uint8_t byte, uint8_t action)
+	{
+		const uint16_t existing = GetNext(state, byte);
+		if (existing != START_STATE && m_actions[existing] == action)
+		{
+			return existing;
+		}
+
+		assert(existing == START_STATE);
+		const uint16_t next = AddState(action);
+		SetNext(state, byte, next);
+		return next;
+	}
+
+	std::vector<uint16_t> m_transitions; // 256 entries per state.
+	std::vector<uint8_t> m_actions;
+	std::vector<uint32_t> m_tokenIds;
+	uint32_t m_maxDigits;
+	uint8_t m_startBytes[MAX_START_BYTES];
+	uint32_t m_numStartBytes;
+
+	// Stream state carried between Scan calls.
+	uint16_t m_state;
+	int64_t m_value;
+	Token m_current;
+};
@@ -9,6 +9,7 @@
 #include "ACUtils/Debug.h"
 
 #include "AdventGUIConsole.h"
+#include "AdventGUIProfiler.h"
 
 AdventGUIInstance* AdventGUIInstance::s_Instance = nullptr;
 
@@ -66,6 +67,10 @@ void AdventGUIInstance::OnKeyAction(struct GLFWwindow* window, int key, int scan
 	{
 		ToggleImGuiDemoWindow();
 	}
+	else if (key == GLFW_KEY_F2 && action == GLFW_RELEASE)
+	{
+		AdventGUIProfiler::Get().TogglePanel();
+	}
 }
 
 AdventGUIInstance::AdventGUIInstance(const AdventGUIParams& params)
@@ -149,6 +154,18 @@ void AdventGUIInstance::InternalCreate()
 
 void AdventGUIInstance::InternalDestroy()
 {
+	WriteMemoryReport();
+
+#if AC_PROFILING
+	Profiler::Collect();
+	if (m_params.profileTraceFilename && Profiler::WriteChromeTrace(m_params.profileTraceFilename))
+	{
+		Log("Wrote profile trace to %s", m_params.profileTraceFilename);
+	}
+#endif
+
+	AdventGUIConsole::Get().FlushDeferred();
+
 	if (!m_appWindow)
 	{
 		return;
@@ -195,12 +212,22 @@ void AdventGUIInstance::DoFrame()
 	
 	if (HasExecFlags(AdventExecuteFlags::AEF_PartOne))
 	{
-		PartOne(context);
+		BeginPhaseTracking();
+		{
+			AC_PROFILE_SCOPE("PartOne");
+			PartOne(context);
+		}
+		EndPhaseTracking(AdventPhase::PartOne, !HasExecFlags(AdventExecuteFlags::AEF_PartOne));
 	}
 
 	if (HasExecFlags(AdventExecuteFlags::AEF_PartTwo))
 	{
-		PartTwo(context);
+		BeginPhaseTracking();
+		{
+			AC_PROFILE_SCOPE("PartTwo");
+			PartTwo(context);
+		}
+		EndPhaseTracking(AdventPhase::PartTwo, !HasExecFlags(AdventExecuteFlags::AEF_PartTwo));
 	}
 
 	if (m_showImGuiDemo)
@@ -223,13 +250,79 @@ void AdventGUIInstance::PartTwo(const AdventGUIContext& context)
 	SetExecFlags(AdventExecuteFlags::AEF_None);
 }
 
+static const char* s_phaseNames[] = { "ParseInput", "PartOne", "PartTwo" };
+
+void AdventGUIInstance::BeginPhaseTracking()
+{
+#if AC_MEMORY_TRACKING
+	Memory::AllocationTracker::Get().BeginPhase();
+#endif
+}
+
+void AdventGUIInstance::EndPhaseTracking(AdventPhase phase, bool phaseComplete)
+{
+#if AC_MEMORY_TRACKING
+	// Parts can run over several frames, so accumulate until the part hands off.
+	const Memory::AllocationStats frameStats = Memory::AllocationTracker::Get().EndPhase();
+	Memory::AllocationStats& stats = m_phaseAllocStats[(size_t)phase];
+	stats.allocCount += frameStats.allocCount;
+	stats.freeCount += frameStats.freeCount;
+	stats.bytesAllocated += frameStats.bytesAllocated;
+	stats.peakLiveHeapBytes = std::max(stats.peakLiveHeapBytes, frameStats.peakLiveHeapBytes);
+	stats.largestAlloc = std::max(stats.largestAlloc, frameStats.largestAlloc);
+	stats.arenaAllocCount += frameStats.arenaAllocCount;
+	stats.arenaBytes += frameStats.arenaBytes;
+
+	if (phaseComplete)
+	{
+		Log("[Memory] %s: allocs %llu, frees %llu, bytes %llu, peak live heap bytes %llu, largest %llu, arena allocs %llu, arena bytes %llu",
+			s_phaseNames[(size_t)phase], stats.allocCount, stats.freeCount, stats.bytesAllocated, stats.peakLiveHeapBytes, stats.largestAlloc, stats.arenaAllocCount, stats.arenaBytes);
+	}
+#endif
+}
+
+void AdventGUIInstance::WriteMemoryReport() const
+{
+#if AC_MEMORY_TRACKING
+	if (!m_params.memoryReportFilename)
+	{
+		return;
+	}
+
+	FILE* reportFile = nullptr;
+	if (fopen_s(&reportFile, m_params.memoryReportFilename, "w") != 0 || !reportFile)
+	{
+		Log("[Memory] Failed to open %s for writing.", m_params.memoryReportFilename);
+		return;
+	}
+
+	fprintf(reportFile, "{\n\t\"year\": %u,\n\t\"day\": %u,\n\t\"phases\": [\n", m_params.year, m_params.day);
+	for (size_t i = 0; i < (size_t)AdventPhase::Count; ++i)
+	{
+		const Memory::AllocationStats& stats = m_phaseAllocStats[i];
+		fprintf(reportFile, "\t\t{ \"name\": \"%s\", \"allocCount\": %llu, \"freeCount\": %llu, \"bytesAllocated\": %llu, \"peakLiveHeapBytes\": %llu, \"largestAlloc\": %llu, \"arenaAllocCount\": %llu, \"arenaBytes\": %llu }%s\n",
+			s_phaseNames[i], stats.allocCount, stats.freeCount, stats.bytesAllocated, stats.peakLiveHeapBytes, stats.largestAlloc, stats.arenaAllocCount, stats.arenaBytes,
+			i + 1 < (size_t)AdventPhase::Count ? "," : "");
+	}
+	fprintf(reportFile, "\t]\n}\n");
+	fclose(reportFile);
+#endif
+}
+
 void AdventGUIInstance::EndFrame()
 {
 	/*
 		Render any geo...
 	*/
 
+#if AC_PROFILING
+	// Draw Profiler
+	Profiler::Collect();
+	AdventGUIProfiler::Get().Draw();
+#endif
+
 	// Draw Console
+	AdventGUIConsole::Get().FlushDeferred();
 	AdventGUIConsole::Get().Draw();
 
 	// Prepare IMGui data stream.
@@ -3,6 +3,7 @@
 #include "ACUtils/FileStream.h"
 #include "ACUtils/Enum.h"
 #include "ACUtils/Memory.h"
+#include "ACUtils/Profiler.h"
 #include "ACUtils/Vec.h"
 
 #include "AdventGUIConsole.h"
@@ -40,6 +41,8 @@ struct AdventGUIParams
 	uint32_t year = 2023;
 	const char* puzzleTitle = nullptr; 
 	const char* inputFilename = nullptr;
+	const char* memoryReportFilename = "memory_report.json"; // Per phase allocation stats. Only written when built with AC_MEMORY_TRACKING=1.
+	const char* profileTraceFilename = "profile_trace.json"; // Chrome trace of every AC_PROFILE_SCOPE. Only written when built with AC_PROFILING=1.
 	Vec4 clearColor = Vec4(0.45f, 0.55f, 0.60f, 1.00f); // Backbuffer Clear color
 };
 
@@ -55,7 +58,40 @@ namespace AdventGUIColor
 	extern const Vec4 Purple;
 }
 
-#define ACLOG(x, ...)  AdventGUIInstance::Get().Log(x, __VA_ARGS__);
+// Compile time log levels. Anything below AC_LOG_LEVEL is compiled out entirely, arguments included.
+#define AC_LOG_LEVEL_VERBOSE 0
+#define AC_LOG_LEVEL_INFO 1
+#define AC_LOG_LEVEL_WARNING 2
+#define AC_LOG_LEVEL_ERROR 3
+#define AC_LOG_LEVEL_NONE 4
+
+#if !defined(AC_LOG_LEVEL)
+#define AC_LOG_LEVEL AC_LOG_LEVEL_INFO
+#endif
+
+#if AC_LOG_LEVEL <= AC_LOG_LEVEL_VERBOSE
+#define ACLOG_VERBOSE(x, ...) AdventGUIInstance::Get()->Log(x, ##__VA_ARGS__)
+#else
+#define ACLOG_VERBOSE(x, ...) do { } while (0)
+#endif
+
+#if AC_LOG_LEVEL <= AC_LOG_LEVEL_INFO
+#define ACLOG(x, ...) AdventGUIInstance::Get()->Log(x, ##__VA_ARGS__)
+#else
+#define ACLOG(x, ...) do { } while (0)
+#endif
+
+#if AC_LOG_LEVEL <= AC_LOG_LEVEL_WARNING
+#define ACLOG_WARNING(x, ...) AdventGUIInstance::Get()->Log("Warning: " x, ##__VA_ARGS__)
+#else
+#define ACLOG_WARNING(x, ...) do { } while (0)
+#endif
+
+#if AC_LOG_LEVEL <= AC_LOG_LEVEL_ERROR
+#define ACLOG_ERROR(x, ...) AdventGUIInstance::Get()->Log("Error: " x, ##__VA_ARGS__)
+#else
+#define ACLOG_ERROR(x, ...) do { } while (0)
+#endif
 
 class AdventGUIInstance
 {
@@ -69,14 +105,19 @@ public:
 	static void InstantiateAndExecute(const AdventGUIParams& params, Args&&... args)
 	{
 		static_assert(std::is_base_of<AdventGUIInstance, T>::value, "Class must inherit from AdventGUIInstance");
-		T* newInstance = new T(params, std::forward(args)...);
+		T* newInstance = new T(params, std::forward<Args>(args)...);
 		
 		s_Instance = newInstance->As<AdventGUIInstance>();
 
 		if (s_Instance->GetInputFileName())
 		{
 			FileStreamReader inputFile(s_Instance->GetInputFileName());
-			s_Instance->ParseInput(inputFile);
+			s_Instance->BeginPhaseTracking();
+			{
+				AC_PROFILE_SCOPE("ParseInput");
+				s_Instance->ParseInput(inputFile);
+			}
+			s_Instance->EndPhaseTracking(AdventPhase::ParseInput, true);
 		}
 
 		// Begin exec loop
@@ -116,15 +157,12 @@ public:
 	void RequestExit(bool exit);
 	void OnKeyAction(struct GLFWwindow* window, int key, int scancode, int action, int mods);
 
-	void Log(const char* fmt, ...) const
+	// Deferred, the line is formatted when the console flushes at the end of the frame. Safe to call from worker threads.
+	// fmt must be a string literal; string arguments are copied.
+	template<typename ...Args>
+	void Log(const char* fmt, Args... args) const
 	{
-		char appendedLog[1024] = { 0 };
-		va_list args;
-		va_start(args, fmt);
-		vsprintf_s(appendedLog, 1024, fmt, args);
-		va_end(args);
-
-		AdventGUIConsole::Get().Log("[%8f] %s", m_appLifetime, appendedLog);
+		AdventGUIConsole::Get().LogDeferred(m_appLifetime, fmt, args...);
 	}
 
 	void VLog(const char* fmt, va_list args) const
@@ -146,7 +184,19 @@ protected:
 	virtual void PartOne(const AdventGUIContext& context);
 	virtual void PartTwo(const AdventGUIContext& context);
 private:
-	
+	enum class AdventPhase : uint8_t
+	{
+		ParseInput = 0,
+		PartOne,
+		PartTwo,
+		Count
+	};
+
+	// Allocation tracking, no-ops unless AC_MEMORY_TRACKING is enabled.
+	void BeginPhaseTracking();
+	void EndPhaseTracking(AdventPhase phase, bool phaseComplete);
+	void WriteMemoryReport() const;
+
 	void InternalCreate();
 	void InternalDestroy();
 	void PollEvents();
@@ -161,6 +211,7 @@ private:
 	Memory::LinearAllocator m_imguiFrameAllocator;
 	struct GLFWwindow* m_appWindow;
 	AdventGUIContext m_context;
+	Memory::AllocationStats m_phaseAllocStats[(size_t)AdventPhase::Count];
 	double m_appLifetime;
 	double m_lastTimeStamp;
 	bool m_showImGuiDemo;
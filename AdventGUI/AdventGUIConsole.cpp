@@ -20,6 +20,8 @@ int TextEditCallbackStub(ImGuiInputTextCallbackData* data)
 
 AdventGUIConsole::AdventGUIConsole()
 : m_Allocator(4 * 1024 * 1024, &OutOfConsoleMemory),
+m_MainThread(std::this_thread::get_id()),
+m_ReportedDrops(0),
 m_Enable(false),
 m_AutoScroll(true),
 m_ScrollToBottom(false),
@@ -96,6 +98,23 @@ void AdventGUIConsole::ExecuteCommand(const char* command)
 	Log("Command [%s] not found.", commandStr);
 }
 
+void AdventGUIConsole::FlushDeferred()
+{
+	assert(std::this_thread::get_id() == m_MainThread);
+
+	m_DeferredLog.Drain([this](double timestamp, const char* line)
+	{
+		Log("[%8f] %s", timestamp, line);
+	});
+
+	const uint64_t dropped = m_DeferredLog.GetDroppedCount();
+	if (dropped != m_ReportedDrops)
+	{
+		Log("Deferred log full, dropped %llu lines.", dropped - m_ReportedDrops);
+		m_ReportedDrops = dropped;
+	}
+}
+
 void AdventGUIConsole::Draw()
 {
 	if (!m_Enable)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "ACUtils/DeferredLog.h"
 #include "ACUtils/Memory.h"
 
 #include "imgui.h"
@@ -9,6 +10,7 @@
 #include <stdarg.h>
 #include <vector>
 #include <cstdio>
+#include <thread>
 #include <unordered_map>
 
 class AdventGUIConsole
@@ -44,6 +46,21 @@ public:
 		printf_s("%s\n", printBuffer);
 	};
 
+	// Binary deferred log, safe to call from any thread. Only the format pointer and argument values are stored here,
+	// the line is formatted and echoed when the main thread calls FlushDeferred (once a frame).
+	template<typename ...Args>
+	void LogDeferred(double timestamp, const char* fmt, Args... args)
+	{
+		if (!m_DeferredLog.Push(timestamp, fmt, args...) && std::this_thread::get_id() == m_MainThread)
+		{
+			// Our own ring is full, so drain it and try again. Worker threads just drop the line (and it's counted).
+			FlushDeferred();
+			m_DeferredLog.Push(timestamp, fmt, args...);
+		}
+	}
+
+	void FlushDeferred();
+
 	void RegisterCommand(const char* command, GUIConsoleCommandCB callback);
 	void ExecuteCommand(const char* command);
 	void Enable() { m_Enable = true; }
@@ -58,6 +75,9 @@ private:
 	typedef std::unordered_map<size_t, GUIConsoleCommandCB> HashToCommandCBMap;
 
 	Memory::Ringbuffer       m_Allocator;
+	DeferredLog::Logger      m_DeferredLog;
+	std::thread::id          m_MainThread;
+	uint64_t                 m_ReportedDrops;
 	std::vector<uintptr_t>   m_LogEntries;
 	std::vector<const char*> m_Commands;
 	HashToCommandCBMap	     m_RegisterCommands;
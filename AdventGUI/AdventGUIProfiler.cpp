@@ -0,0 +1,128 @@
+#include "AdventGUIProfiler.h"
+
+#include "ACUtils/Hash.h"
+#include "ACUtils/Profiler.h"
+
+#include "AdventGUIConsole.h"
+
+#include "imgui.h"
+#include <algorithm>
+
+AdventGUIProfiler::AdventGUIProfiler()
+: m_Enable(false),
+m_Zoom(1.0f),
+m_RowHeight(18.0f),
+m_ExportFilename("profile_trace.json")
+{
+
+}
+
+AdventGUIProfiler::~AdventGUIProfiler()
+{
+
+}
+
+static ImU32 GetScopeColor(const char* name)
+{
+	// Names are literals, so the pointer is a stable identity.
+	const uint64_t hash = Hash::Hash64((uint64_t)(uintptr_t)name);
+	return IM_COL32(96 + (hash & 0x7F), 96 + ((hash >> 8) & 0x7F), 96 + ((hash >> 16) & 0x7F), 255);
+}
+
+void AdventGUIProfiler::Draw()
+{
+	if (!m_Enable)
+	{
+		return;
+	}
+
+	const std::vector<Profiler::Event>& events = Profiler::GetEvents();
+
+	ImGui::SetNextWindowSize(ImVec2(900, 400), ImGuiCond_FirstUseEver);
+	if (!ImGui::Begin("Profiler", &m_Enable))
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("Events: %zu  Dropped: %llu", events.size(), Profiler::GetDroppedCount());
+	ImGui::SameLine();
+	if (ImGui::Button("Clear"))
+	{
+		Profiler::ClearEvents();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Export"))
+	{
+		if (Profiler::WriteChromeTrace(m_ExportFilename))
+		{
+			AdventGUIConsole::Get().Log("Wrote profile trace to %s", m_ExportFilename);
+		}
+	}
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(200.0f);
+	ImGui::SliderFloat("Zoom", &m_Zoom, 1.0f, 10000.0f, "%.1fx", ImGuiSliderFlags_Logarithmic);
+	ImGui::Separator();
+
+	if (events.empty())
+	{
+		ImGui::TextUnformatted("Nothing recorded. Build with AC_PROFILING=1 and add AC_PROFILE_SCOPE to the code you care about.");
+		ImGui::End();
+		return;
+	}
+
+	uint64_t startNs = ~0ULL;
+	uint64_t endNs = 0;
+	uint32_t maxThread = 0;
+	uint32_t maxDepth = 0;
+	for (const Profiler::Event& event : events)
+	{
+		startNs = std::min(startNs, event.startNs);
+		endNs = std::max(endNs, event.endNs);
+		maxThread = std::max(maxThread, event.threadIndex);
+		maxDepth = std::max(maxDepth, event.depth);
+	}
+	const double rangeNs = (double)std::max<uint64_t>(endNs - startNs, 1);
+
+	if (ImGui::BeginChild("Timeline", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar))
+	{
+		const float laneHeight = (maxDepth + 1) * m_RowHeight + 4.0f;
+		const float timelineWidth = ImGui::GetContentRegionAvail().x * m_Zoom;
+		ImGui::Dummy(ImVec2(timelineWidth, laneHeight * (maxThread + 1)));
+
+		const ImVec2 origin = ImGui::GetItemRectMin();
+		const float visibleMin = ImGui::GetScrollX();
+		const float visibleMax = visibleMin + ImGui::GetWindowWidth();
+		const double pixelsPerNs = timelineWidth / rangeNs;
+		const ImVec2 mouse = ImGui::GetMousePos();
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+		for (const Profiler::Event& event : events)
+		{
+			const float x0 = (float)((event.startNs - startNs) * pixelsPerNs);
+			const float x1 = std::max(x0 + 1.0f, (float)((event.endNs - startNs) * pixelsPerNs));
+			if (x1 < visibleMin || x0 > visibleMax)
+			{
+				continue;
+			}
+
+			const ImVec2 rectMin(origin.x + x0, origin.y + event.threadIndex * laneHeight + event.depth * m_RowHeight);
+			const ImVec2 rectMax(origin.x + x1, rectMin.y + m_RowHeight - 1.0f);
+			drawList->AddRectFilled(rectMin, rectMax, GetScopeColor(event.name));
+			if (rectMax.x - rectMin.x > 32.0f)
+			{
+				drawList->PushClipRect(rectMin, rectMax, true);
+				drawList->AddText(ImVec2(rectMin.x + 2.0f, rectMin.y + 1.0f), IM_COL32_BLACK, event.name);
+				drawList->PopClipRect();
+			}
+
+			if (ImGui::IsWindowHovered() && mouse.x >= rectMin.x && mouse.x < rectMax.x && mouse.y >= rectMin.y && mouse.y < rectMax.y)
+			{
+				ImGui::SetTooltip("%s\n%.3f ms (thread %u)", event.name, (double)(event.endNs - event.startNs) / 1000000.0, event.threadIndex);
+			}
+		}
+	}
+	ImGui::EndChild();
+
+	ImGui::End();
+}
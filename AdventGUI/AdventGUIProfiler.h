@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+// ImGui timeline / flame view of everything recorded with AC_PROFILE_SCOPE. One row per thread, nested scopes stack downwards.
+class AdventGUIProfiler
+{
+public:
+	static AdventGUIProfiler& Get()
+	{
+		static AdventGUIProfiler s_Instance;
+		return s_Instance;
+	}
+
+	void Enable() { m_Enable = true; }
+	void Disable() { m_Enable = false; }
+	void TogglePanel() { m_Enable = !m_Enable; }
+	void Draw();
+private:
+	AdventGUIProfiler();
+	~AdventGUIProfiler();
+
+	bool  m_Enable;
+	float m_Zoom;        // 1 = whole capture fits the panel.
+	float m_RowHeight;
+	const char* m_ExportFilename;
+};
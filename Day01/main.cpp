@@ -4,7 +4,8 @@
 #include "AdventGUI/AdventGUI.h"
 #include "imgui.h"
 
-#include "ACUtils/StringUtil.h"
+#include "ACUtils/Algorithm.h"
+#include "ACUtils/SIMD.h"
 #include <array>
 #include <string>
 #include <algorithm>
@@ -19,43 +20,28 @@ private:
 	{
 		// Parse Input. Input never changes between parts of a problem.
 		std::string line;
-		std::vector<std::string> tokens;
+		char* pairEnd = nullptr;
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
 			if (!line.empty())
 			{
-				StringUtil::SplitBy(line, " ", tokens, true);
-				assert(tokens.size() == 2);
-				m_leftSide.push_back(atoi(tokens[0].c_str()));
-				m_rightSide.push_back(atoi(tokens[1].c_str()));
-
-				std::unordered_map<int, int>::iterator itFind = m_occuranceMap.find(m_rightSide.back());
-				if (itFind == m_occuranceMap.end())
-				{
-					m_occuranceMap.insert(std::make_pair(m_rightSide.back(), 1));
-				}
-				else
-				{
-					itFind->second++;
-				}
+				m_leftSide.push_back((int32_t)strtol(line.c_str(), &pairEnd, 10));
+				m_rightSide.push_back((int32_t)strtol(pairEnd, nullptr, 10));
 			}
 		}
 
-		std::sort(m_leftSide.begin(), m_leftSide.end());
-		std::sort(m_rightSide.begin(), m_rightSide.end());
+		std::vector<int32_t> scratch(m_leftSide.size());
+		Algorithm::radix_sort(m_leftSide.data(), m_leftSide.size(), scratch.data());
+		Algorithm::radix_sort(m_rightSide.data(), m_rightSide.size(), scratch.data());
 	}
 
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
-		int sum = 0;
-		for (size_t i = 0; i < m_leftSide.size(); ++i)
-		{
-			sum += abs(m_leftSide[i] - m_rightSide[i]);
-		}
+		uint64_t sum = SIMD::SumAbsoluteDifferences(m_leftSide.data(), m_rightSide.data(), m_leftSide.size());
 
-		Log("Total Sum = %d", sum);
+		Log("Total Sum = %llu", sum);
 
 		// Done.
 		 AdventGUIInstance::PartOne(context);
@@ -64,14 +50,36 @@ private:
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
+		// Both columns are sorted, so walk them together and multiply matching runs rather than building an occurrence map.
 		uint64_t sum = 0;
-		std::unordered_map<int, int>::const_iterator itFind;
-		for (size_t i = 0; i < m_leftSide.size(); ++i)
+		size_t left = 0;
+		size_t right = 0;
+		while (left < m_leftSide.size() && right < m_rightSide.size())
 		{
-			itFind = m_occuranceMap.find(m_leftSide[i]);
-			if (itFind != m_occuranceMap.end())
+			const int32_t value = m_leftSide[left];
+			if (value < m_rightSide[right])
+			{
+				++left;
+			}
+			else if (value > m_rightSide[right])
+			{
+				++right;
+			}
+			else
 			{
-				sum += m_leftSide[i] * itFind->second;
+				uint64_t leftCount = 0;
+				uint64_t rightCount = 0;
+				for (; left < m_leftSide.size() && m_leftSide[left] == value; ++left)
+				{
+					++leftCount;
+				}
+
+				for (; right < m_rightSide.size() && m_rightSide[right] == value; ++right)
+				{
+					++rightCount;
+				}
+
+				sum += (uint64_t)value * leftCount * rightCount;
 			}
 		}
 
@@ -81,9 +89,8 @@ private:
 		AdventGUIInstance::PartTwo(context);
 	}
 
-	std::vector<int> m_leftSide;
-	std::vector<int> m_rightSide;
-	std::unordered_map<int, int> m_occuranceMap;
+	std::vector<int32_t> m_leftSide;
+	std::vector<int32_t> m_rightSide;
 };
 
 int main()
@@ -1,4 +1,5 @@
 #include "AdventGUI/AdventGUI.h"
+#include "ACUtils/Bit.h"
 
 class AdventDay : public AdventGUIInstance
 {
@@ -10,28 +11,32 @@ private:
 	{
 		// Parse Input. Input never changes between parts of a problem.
 		std::string line;
-		std::vector<std::string> tokens;
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
-			StringUtil::SplitBy(line, " ", tokens);
-			m_reports.emplace_back(tokens);
+			if (line.empty())
+			{
+				continue;
+			}
+
+			Report rpt;
+			rpt.offset = (uint32_t)m_levels.size();
+			const char* cursor = line.c_str();
+			char* next = nullptr;
+			for (long value = strtol(cursor, &next, 10); next != cursor; value = strtol(cursor, &next, 10))
+			{
+				m_levels.push_back((int32_t)value);
+				cursor = next;
+			}
+			rpt.count = (uint32_t)m_levels.size() - rpt.offset;
+			m_reports.push_back(rpt);
 		}
 	}
 
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
-
-		int numSafe = 0;
-		for (const Report& rpt : m_reports)
-		{
-			if (rpt.IsSafe())
-			{
-				++numSafe;
-			}
-
-		}
+		int numSafe = CountSafe(false);
 
 		Log("Total Safe = %d", numSafe);
 
@@ -42,15 +47,7 @@ private:
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
-		int numSafe = 0;
-
-		for (const Report& rpt : m_reports)
-		{
-			if (rpt.IsSafe() || CanBeMadeSafe(rpt))
-			{
-				++numSafe;
-			}
-		}
+		int numSafe = CountSafe(true);
 
 		Log("Total Safe = %d", numSafe);
 
@@ -58,85 +55,84 @@ private:
 		AdventGUIInstance::PartTwo(context);
 	}
 
+	// Reports are stored back to back in m_levels.
 	struct Report
 	{
-	public:
-		Report(const std::vector<std::string>& valueArray)
-		: values(),
-		safe(true)
-		{
-			int lastValue = -1;
-			uint32_t sign = ~0U;
-			int delta = 0;
-			uint32_t deltaSign = 0;
+		uint32_t offset = 0;
+		uint32_t count = 0;
+	};
+
+	// Step from a to b is safe when it moves 1-3 in dir (+1 increasing, -1 decreasing).
+	static bool IsSafeStep(int32_t a, int32_t b, int32_t dir)
+	{
+		int32_t delta = (b - a) * dir;
+		return delta >= 1 && delta <= 3;
+	}
 
-			values.reserve(valueArray.size());
-			for (const std::string& valueStr : valueArray)
+	// One pass over the steps to find the first and last unsafe step. Removing level k only leaves steps k-1 -> k+1 plus the
+	// untouched prefix/suffix, so k has to sit in [lastBad, firstBad + 1] (at most two candidates) and bridge its neighbours.
+	static bool IsSafeInDirection(const int32_t* levels, uint32_t count, int32_t dir, bool allowRemoval)
+	{
+		uint32_t firstBad = count;
+		uint32_t lastBad = count;
+		for (uint32_t i = 0; i + 1 < count; ++i)
+		{
+			if (!IsSafeStep(levels[i], levels[i + 1], dir))
 			{
-				values.push_back(atoi(valueStr.c_str()));
-				if (lastValue < 0)
-				{
-					lastValue = values.back();
-				}
-				else if (safe)
-				{
-					if (lastValue == values.back())
-					{
-						safe = false;
-					}
-					else 
-					{
-						delta = values.back() - lastValue;
-						deltaSign = (uint32_t)delta & (1 << 7);
-						if (sign == ~0U)
-						{
-							sign = deltaSign;
-						}
-						else
-						{
-							safe &= (deltaSign == sign);
-						}
-						safe &= abs(delta) <= 3;
-						lastValue = values.back();
-					}
-				}
+				firstBad = firstBad == count ? i : firstBad;
+				lastBad = i;
 			}
 		}
 
-		bool IsSafe() const
+		if (firstBad == count)
 		{
-			return safe;
+			return true;
 		}
 
-		std::vector<int> values;
-		bool safe;
-	};
-
+		if (!allowRemoval)
+		{
+			return false;
+		}
 
-	bool CheckSafety(const std::vector<int>& values) const
-	{
-		uint32_t sign = ~0U;
-		int delta = 0;
-		uint32_t deltaSign = 0;
-		for (int i = 1; i < values.size(); ++i)
+		for (uint32_t k = lastBad; k <= firstBad + 1 && k < count; ++k)
 		{
-			delta = values[i] - values[i - 1];
-			deltaSign = (uint32_t)delta & (1 << 7);
-			if (delta == 0)
+			if (k == 0 || k + 1 == count || IsSafeStep(levels[k - 1], levels[k + 1], dir))
 			{
-				return false;
+				return true;
 			}
+		}
 
-			if (sign == ~0U)
-			{
-				sign = deltaSign;
-			}
-			else if (sign != deltaSign)
-			{
-				return false;
-			}
+		return false;
+	}
+
+	bool IsSafe(const Report& rpt, bool allowRemoval) const
+	{
+		const int32_t* levels = m_levels.data() + rpt.offset;
+		return IsSafeInDirection(levels, rpt.count, 1, allowRemoval) || IsSafeInDirection(levels, rpt.count, -1, allowRemoval);
+	}
+
+	// Batched path: 16 reports at a time, transposed so lane i of batch.levels[j] is level j of report i.
+	static constexpr uint32_t BATCH_LANES = 16;
+	static constexpr uint32_t BATCH_MAX_LEVELS = 8;
 
-			if (abs(delta) > 3)
+	struct alignas(16) ReportBatch
+	{
+		int8_t levels[BATCH_MAX_LEVELS][BATCH_LANES];
+		int8_t counts[BATCH_LANES];
+		uint32_t numLanes;
+	};
+
+	bool FitsBatch(const Report& rpt) const
+	{
+		if (rpt.count > BATCH_MAX_LEVELS)
+		{
+			return false;
+		}
+
+		for (uint32_t i = 0; i < rpt.count; ++i)
+		{
+			const int32_t level = m_levels[rpt.offset + i];
+			if (level < 0 || level > 127) // Keeps every difference inside int8.
 			{
 				return false;
 			}
@@ -144,32 +140,105 @@ private:
 
 		return true;
 	}
-	
-	bool CanBeMadeSafe(const Report& rpt) const
+
+	// Lane mask of steps from level j to level j + stride that are safe in dir. Steps past the end of a report count as safe.
+	static __m128i SafeStepMask(const ReportBatch& batch, __m128i counts, uint32_t j, uint32_t stride, int32_t dir)
 	{
-		if (rpt.IsSafe())
+		if (j + stride >= BATCH_MAX_LEVELS)
 		{
-			return true;
+			return _mm_set1_epi8(-1);
+		}
+
+		const __m128i a = _mm_load_si128((const __m128i*)batch.levels[j]);
+		const __m128i b = _mm_load_si128((const __m128i*)batch.levels[j + stride]);
+		const __m128i delta = dir > 0 ? _mm_sub_epi8(b, a) : _mm_sub_epi8(a, b);
+		const __m128i safe = _mm_and_si128(_mm_cmpgt_epi8(delta, _mm_setzero_si128()), _mm_cmplt_epi8(delta, _mm_set1_epi8(4)));
+		const __m128i missing = _mm_cmpgt_epi8(_mm_set1_epi8((char)(j + stride + 1)), counts);
+		return _mm_or_si128(safe, missing);
+	}
+
+	// Same prefix/suffix reasoning as IsSafeInDirection, just for every removal index and every lane at once.
+	static __m128i SafeBatchInDirection(const ReportBatch& batch, int32_t dir, bool allowRemoval)
+	{
+		const __m128i counts = _mm_load_si128((const __m128i*)batch.counts);
+		const __m128i allSet = _mm_set1_epi8(-1);
+
+		__m128i steps[BATCH_MAX_LEVELS];
+		__m128i prefix[BATCH_MAX_LEVELS + 1]; // prefix[j] = steps 0..j-1 all safe
+		__m128i suffix[BATCH_MAX_LEVELS + 1]; // suffix[j] = steps j.. all safe
+		prefix[0] = allSet;
+		for (uint32_t j = 0; j < BATCH_MAX_LEVELS; ++j)
+		{
+			steps[j] = SafeStepMask(batch, counts, j, 1, dir);
+			prefix[j + 1] = _mm_and_si128(prefix[j], steps[j]);
 		}
 
-		std::vector<int> reportVariant;
-		reportVariant.reserve(rpt.values.size());
-		for (int i = 0; i < rpt.values.size(); ++i)
+		if (!allowRemoval)
 		{
-			reportVariant.clear();
-			reportVariant.insert(reportVariant.begin(), rpt.values.begin(), rpt.values.end());
-			reportVariant.erase(reportVariant.begin() + i);
-			if (CheckSafety(reportVariant))
-			{
-				return true;
-			}
+			return prefix[BATCH_MAX_LEVELS];
 		}
 
-		return false;
+		suffix[BATCH_MAX_LEVELS] = allSet;
+		for (uint32_t j = BATCH_MAX_LEVELS; j > 0; --j)
+		{
+			suffix[j - 1] = _mm_and_si128(suffix[j], steps[j - 1]);
+		}
+
+		__m128i safe = suffix[1]; // Drop level 0.
+		for (uint32_t k = 1; k < BATCH_MAX_LEVELS; ++k)
+		{
+			__m128i removeK = _mm_and_si128(prefix[k - 1], suffix[k + 1]);
+			removeK = _mm_and_si128(removeK, SafeStepMask(batch, counts, k - 1, 2, dir));
+			safe = _mm_or_si128(safe, removeK);
+		}
+
+		return safe;
+	}
+
+	static uint32_t CountSafeBatch(const ReportBatch& batch, bool allowRemoval)
+	{
+		const __m128i safe = _mm_or_si128(SafeBatchInDirection(batch, 1, allowRemoval), SafeBatchInDirection(batch, -1, allowRemoval));
+		const uint32_t laneMask = (uint32_t)Bits::CreateBitMask(0, batch.numLanes);
+		return Bits::PopCount32((uint32_t)_mm_movemask_epi8(safe) & laneMask);
 	}
 
+	int CountSafe(bool allowRemoval) const
+	{
+		int numSafe = 0;
+		ReportBatch batch;
+		memset(&batch, 0, sizeof(batch));
+
+		for (const Report& rpt : m_reports)
+		{
+			if (!FitsBatch(rpt))
+			{
+				numSafe += IsSafe(rpt, allowRemoval) ? 1 : 0;
+				continue;
+			}
 
+			const uint32_t lane = batch.numLanes++;
+			batch.counts[lane] = (int8_t)rpt.count;
+			for (uint32_t i = 0; i < BATCH_MAX_LEVELS; ++i)
+			{
+				batch.levels[i][lane] = i < rpt.count ? (int8_t)m_levels[rpt.offset + i] : 0;
+			}
+
+			if (batch.numLanes == BATCH_LANES)
+			{
+				numSafe += CountSafeBatch(batch, allowRemoval);
+				memset(&batch, 0, sizeof(batch));
+			}
+		}
+
+		if (batch.numLanes)
+		{
+			numSafe += CountSafeBatch(batch, allowRemoval);
+		}
+
+		return numSafe;
+	}
 
+	std::vector<int32_t> m_levels;
 	std::vector<Report> m_reports;
 };
 
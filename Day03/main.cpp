@@ -1,5 +1,14 @@
 #include "AdventGUI/AdventGUI.h"
+#include "ACUtils/TokenScanner.h"
+
+// Set to 1 to time the scanner against the old std::regex path on a ~1GB input built by repeating the puzzle input.
+#if !defined(DAY03_BENCHMARK)
+#define DAY03_BENCHMARK 0
+#endif
+
+#if DAY03_BENCHMARK
 #include <regex>
+#endif
 
 class AdventDay : public AdventGUIInstance
 {
@@ -10,107 +19,156 @@ private:
 	virtual void ParseInput(FileStreamReader& fileReader) override
 	{
 		// Parse Input. Input never changes between parts of a problem.
-		fileReader.ReadAllLines(true, m_input);
+		// Raw bytes, newlines included. The scanner doesn't care about lines.
+		char buffer[64 * 1024];
+		for (size_t bytesRead = fileReader.Read(buffer, sizeof(buffer)); bytesRead > 0; bytesRead = fileReader.Read(buffer, sizeof(buffer)))
+		{
+			m_input.append(buffer, bytesRead);
+		}
 	}
 
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
-		std::regex mulRegex("(mul\\(\\d+,\\d+\\))");
-		std::string foundMatch;
-		size_t leftParen = std::string::npos;
-		size_t rightParen = std::string::npos;
-		size_t comma = std::string::npos;
+		int64_t sum = SumInstructions(m_input.data(), m_input.size(), false);
 
-		std::string leftValue;
-		std::string rightValue;
+		Log("Sum = %lld", sum);
 
-		int64_t sum = 0;
+		// Done.
+		 AdventGUIInstance::PartOne(context);
+	}
 
-		for (const std::string& inputline : m_input)
-		{
-			std::sregex_iterator it = std::sregex_iterator(inputline.begin(), inputline.end(), mulRegex);
-			while (it != std::sregex_iterator())
-			{
-				foundMatch = it->str();
-				leftParen = foundMatch.find('(');
-				assert(leftParen != std::string::npos);
-				comma = foundMatch.find(',');
-				assert(comma != std::string::npos);
-				rightParen = foundMatch.find(')');
-				assert(rightParen != std::string::npos);
+	virtual void PartTwo(const AdventGUIContext& context) override
+	{
+		// Part Two
+		int64_t sum = SumInstructions(m_input.data(), m_input.size(), true);
 
-				leftValue = foundMatch.substr(leftParen + 1, comma - leftParen - 1);
-				rightValue = foundMatch.substr(comma + 1, rightParen - comma - 1);
+		Log("Sum = %lld", sum);
 
-				sum += atoi(leftValue.c_str()) * atoi(rightValue.c_str());
+#if DAY03_BENCHMARK
+		RunBenchmark();
+#endif
+		// Done.
+		AdventGUIInstance::PartTwo(context);
+	}
 
-				++it;
-			}
+	enum Instruction : uint32_t
+	{
+		Mul,
+		Do,
+		Dont,
+	};
+
+	// Streams the program through the scanner. Feed can be called with as many chunks as needed.
+	struct InstructionSum
+	{
+		InstructionSum(bool handleConditionals)
+		: scanner(),
+		handleConditionals(handleConditionals),
+		enabled(true),
+		sum(0)
+		{
+			scanner.AddToken(Mul, "mul(#,#)");
+			scanner.AddToken(Do, "do()");
+			scanner.AddToken(Dont, "don't()");
 		}
 
-		Log("Sum = %lld", sum);
+		void Feed(const char* data, size_t size)
+		{
+			scanner.Scan(data, size, [this](const TokenScanner::Token& token)
+			{
+				switch (token.id)
+				{
+				case Mul:
+					sum += enabled ? token.args[0] * token.args[1] : 0;
+					break;
+				case Do:
+					enabled = true;
+					break;
+				case Dont:
+					enabled = !handleConditionals;
+					break;
+				}
+			});
+		}
 
-		// Done.
-		 AdventGUIInstance::PartOne(context);
+		TokenScanner scanner;
+		bool handleConditionals;
+		bool enabled;
+		int64_t sum;
+	};
+
+	static int64_t SumInstructions(const char* data, size_t size, bool handleConditionals)
+	{
+		InstructionSum instructionSum(handleConditionals);
+		instructionSum.Feed(data, size);
+		return instructionSum.sum;
 	}
 
-	virtual void PartTwo(const AdventGUIContext& context) override
+#if DAY03_BENCHMARK
+	static constexpr size_t BENCHMARK_BYTES = 1024ULL * 1024ULL * 1024ULL;
+
+	// The line by line std::regex solution this day used to use, kept around to compare against.
+	static int64_t SumInstructionsRegex(const std::vector<std::string>& lines)
 	{
-		// Part Two
-		std::regex mulRegex("((do[^n])|(don\\'t)|(mul\\(\\d+,\\d+\\)))");
-		std::string foundMatch;
-		size_t leftParen = std::string::npos;
-		size_t rightParen = std::string::npos;
-		size_t comma = std::string::npos;
-
-		std::string leftValue;
-		std::string rightValue;
-		
+		std::regex mulRegex("((do\\(\\))|(don\\'t\\(\\))|(mul\\((\\d+),(\\d+)\\)))");
 		bool enabled = true;
 		int64_t sum = 0;
-
-		for (const std::string& inputline : m_input)
+		for (const std::string& inputline : lines)
 		{
-			std::sregex_iterator it = std::sregex_iterator(inputline.begin(), inputline.end(), mulRegex);
-			while (it != std::sregex_iterator())
+			for (std::sregex_iterator it(inputline.begin(), inputline.end(), mulRegex); it != std::sregex_iterator(); ++it)
 			{
-				foundMatch = it->str();
-				
-				if (foundMatch.find("don't") != std::string::npos)
+				const std::string foundMatch = it->str();
+				if (foundMatch[2] == 'n')
 				{
 					enabled = false;
 				}
-				else if (foundMatch.find("do") != std::string::npos)
+				else if (foundMatch[0] == 'd')
 				{
 					enabled = true;
 				}
 				else if (enabled)
-				{					
-					leftParen = foundMatch.find('(');
-					assert(leftParen != std::string::npos);
-					comma = foundMatch.find(',');
-					assert(comma != std::string::npos);
-					rightParen = foundMatch.find(')');
-					assert(rightParen != std::string::npos);
-
-					leftValue = foundMatch.substr(leftParen + 1, comma - leftParen - 1);
-					rightValue = foundMatch.substr(comma + 1, rightParen - comma - 1);
-
-					
-					sum += atoi(leftValue.c_str()) * atoi(rightValue.c_str());
+				{
+					sum += atoi((*it)[5].str().c_str()) * atoi((*it)[6].str().c_str());
 				}
-				
-				++it;
 			}
 		}
 
-		Log("Sum = %lld", sum);
-		// Done.
-		AdventGUIInstance::PartTwo(context);
+		return sum;
+	}
+
+	void RunBenchmark()
+	{
+		std::string bigInput;
+		bigInput.reserve(BENCHMARK_BYTES + m_input.size() + 1);
+		while (bigInput.size() < BENCHMARK_BYTES)
+		{
+			bigInput.append(m_input);
+			bigInput.push_back('\n');
+		}
+
+		const double gigabytes = (double)bigInput.size() / (1024.0 * 1024.0 * 1024.0);
+
+		// Fed in 1MB chunks, the way it would stream off disk.
+		uint64_t startNs = Profiler::GetTimestampNs();
+		InstructionSum instructionSum(true);
+		for (size_t offset = 0; offset < bigInput.size(); offset += 1024 * 1024)
+		{
+			instructionSum.Feed(bigInput.data() + offset, std::min<size_t>(1024 * 1024, bigInput.size() - offset));
+		}
+		const double scannerSeconds = (double)(Profiler::GetTimestampNs() - startNs) / 1000000000.0;
+		Log("[Benchmark] Scanner: %.2f GB in %.3fs (%.2f GB/s), sum = %lld", gigabytes, scannerSeconds, gigabytes / scannerSeconds, instructionSum.sum);
+
+		std::vector<std::string> lines;
+		StringUtil::SplitBy(bigInput, "\n", lines, false);
+		startNs = Profiler::GetTimestampNs();
+		const int64_t regexSum = SumInstructionsRegex(lines);
+		const double regexSeconds = (double)(Profiler::GetTimestampNs() - startNs) / 1000000000.0;
+		Log("[Benchmark] std::regex: %.2f GB in %.3fs (%.2f GB/s), sum = %lld", gigabytes, regexSeconds, gigabytes / regexSeconds, regexSum);
 	}
+#endif
 
-	std::vector<std::string> m_input; 
+	std::string m_input;
 };
 
 int main()
@@ -1,6 +1,6 @@
 #include "AdventGUI/AdventGUI.h"
-#include "ACUtils/Algorithm.h"
-#include <unordered_set>
+#include "ACUtils/Bit.h"
+#include <unordered_map>
 
 class AdventDay : public AdventGUIInstance
 {
@@ -8,115 +8,161 @@ public:
 	AdventDay(const AdventGUIParams& params) : AdventGUIInstance(params) {};
 
 private:
-	struct Rule
-	{
-		Rule(int _value):value(_value) {};
-
-		int value;
-		std::unordered_set<int> before;
-	};
-
+	// Updates are stored back to back in m_updatePages as dense page indices.
 	struct Update
 	{
-		std::vector<int> input;
+		uint32_t offset = 0;
+		uint32_t count = 0;
 	};
 
 	virtual void ParseInput(FileStreamReader& fileReader) override
 	{
 		// Parse Input. Input never changes between parts of a problem.
+		std::vector<std::pair<uint32_t, uint32_t>> rules;
 		std::string line;
-		size_t barIdx = std::string::npos;
-		std::vector<std::string> tokens;
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
-			barIdx = line.find('|');
-			if (barIdx != std::string::npos)
+			const char* cursor = line.c_str();
+			char* next = nullptr;
+			if (line.find('|') != std::string::npos)
 			{
-				assert(barIdx != std::string::npos);
-				tokens.clear();
-				tokens.push_back(line.substr(0, barIdx));
-				tokens.push_back(line.substr(barIdx + 1));
-				int page = atoi(tokens[0].c_str());
-				int before = atoi(tokens[1].c_str());
-
-				int existingIndex = GetRuleIndexForPage(page);
-				if (existingIndex == -1)
-				{
-					m_rules.emplace_back(page);
-					m_rules.back().before.insert(before);
-				}
-				else
-				{
-					m_rules[existingIndex].before.insert(before);
-				}
-
-				existingIndex = GetRuleIndexForPage(before);
-				if (existingIndex == -1)
-				{
-					m_rules.emplace_back(before);
-				}
+				const uint32_t page = GetPageIndex((int)strtol(cursor, &next, 10));
+				const uint32_t before = GetPageIndex((int)strtol(next + 1, nullptr, 10));
+				rules.emplace_back(page, before);
 			}
 			else if (!line.empty())
 			{
-				StringUtil::SplitBy(line, ",", tokens);
-				m_updates.emplace_back();
-				Update& newUpdate = m_updates.back();
-				for (const std::string& tok : tokens)
+				Update update;
+				update.offset = (uint32_t)m_updatePages.size();
+				for (long value = strtol(cursor, &next, 10); next != cursor; value = strtol(cursor, &next, 10))
 				{
-					newUpdate.input.push_back(atoi(tok.c_str()));
+					m_updatePages.push_back(GetPageIndex((int)value));
+					cursor = *next == ',' ? next + 1 : next;
 				}
+				update.count = (uint32_t)m_updatePages.size() - update.offset;
+				m_updates.push_back(update);
 			}
 		}
+
+		// Page indices are only known once everything has been read, so the matrices are built last.
+		m_rowWords = (uint32_t)Bits::BitArraySize64(m_pageValues.size());
+		m_precedes.assign(m_pageValues.size() * m_rowWords, 0ULL);
+		m_follows.assign(m_pageValues.size() * m_rowWords, 0ULL);
+		for (const std::pair<uint32_t, uint32_t>& rule : rules)
+		{
+			m_precedes[rule.first * m_rowWords + rule.second / 64] |= 1ULL << (rule.second % 64);
+			m_follows[rule.second * m_rowWords + rule.first / 64] |= 1ULL << (rule.first % 64);
+		}
+		m_pageIndices.clear();
 	}
 
-	int GetRuleIndexForPage(int page) const
+	uint32_t GetPageIndex(int page)
 	{
-		return Algorithm::find_index_of(m_rules.begin(), m_rules.end(), [=](const Rule& LHS) { return LHS.value == page; });
+		auto it = m_pageIndices.find(page);
+		if (it != m_pageIndices.end())
+		{
+			return it->second;
+		}
+
+		const uint32_t index = (uint32_t)m_pageValues.size();
+		m_pageIndices.emplace(page, index);
+		m_pageValues.push_back(page);
+		return index;
 	}
 
-	bool IsUpdateValid(const Update& update) const
+	// Row of page a in either matrix, bit b set when a must come before (m_precedes) or after (m_follows) page b.
+	const uint64_t* GetRow(const std::vector<uint64_t>& matrix, uint32_t page) const
 	{
-		int ruleIdx = -1;
-		for(size_t i = 0; i < update.input.size(); ++i)
+		return matrix.data() + (size_t)page * m_rowWords;
+	}
+
+	// One pass: invalid as soon as a page has to come before something already printed.
+	bool IsUpdateValid(const Update& update, uint64_t* seen) const
+	{
+		memset(seen, 0, m_rowWords * sizeof(uint64_t));
+		for (uint32_t i = 0; i < update.count; ++i)
 		{
-			ruleIdx = GetRuleIndexForPage(update.input[i]);
-			if (ruleIdx != -1)
+			const uint32_t page = m_updatePages[update.offset + i];
+			const uint64_t* row = GetRow(m_precedes, page);
+			for (uint32_t w = 0; w < m_rowWords; ++w)
 			{
-				const Rule& pageRule = m_rules[ruleIdx];
-				for (size_t j = 0; j < update.input.size(); ++j)
+				if (row[w] & seen[w])
 				{
-					if (j == i)
-					{
-						continue;
-					}
+					return false;
+				}
+			}
+			seen[page / 64] |= 1ULL << (page % 64);
+		}
+
+		return true;
+	}
 
-					int otherPage = update.input[j];
-					if (pageRule.before.find(otherPage) != pageRule.before.end())
+	// Kahn's algorithm over the rules restricted to this update's pages. Only the first half of the order is needed to
+	// know the middle page, so it stops there.
+	uint32_t GetReorderedMiddlePage(const Update& update, uint64_t* members, std::vector<uint32_t>& inDegree, std::vector<uint32_t>& ready) const
+	{
+		const uint32_t* pages = m_updatePages.data() + update.offset;
+		memset(members, 0, m_rowWords * sizeof(uint64_t));
+		for (uint32_t i = 0; i < update.count; ++i)
+		{
+			members[pages[i] / 64] |= 1ULL << (pages[i] % 64);
+		}
+
+		ready.clear();
+		for (uint32_t i = 0; i < update.count; ++i)
+		{
+			const uint64_t* row = GetRow(m_follows, pages[i]);
+			uint32_t degree = 0;
+			for (uint32_t w = 0; w < m_rowWords; ++w)
+			{
+				degree += Bits::PopCount64(row[w] & members[w]);
+			}
+
+			inDegree[pages[i]] = degree;
+			if (degree == 0)
+			{
+				ready.push_back(pages[i]);
+			}
+		}
+
+		for (uint32_t placed = 0; !ready.empty(); ++placed)
+		{
+			const uint32_t page = ready.back();
+			ready.pop_back();
+			if (placed == update.count / 2)
+			{
+				return page;
+			}
+
+			const uint64_t* row = GetRow(m_precedes, page);
+			for (uint32_t w = 0; w < m_rowWords; ++w)
+			{
+				for (uint64_t successors = row[w] & members[w]; successors; successors &= successors - 1)
+				{
+					const uint32_t successor = w * 64 + Bits::CountTrailingZeros64(successors);
+					if (--inDegree[successor] == 0)
 					{
-						if (j < i)
-						{
-							return false;
-						}
+						ready.push_back(successor);
 					}
 				}
 			}
 		}
 
-		return true;
+		assert(false); // The rules have a cycle within this update.
+		return pages[update.count / 2];
 	}
 
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
 		int sum = 0;
-		std::vector<int> temp;
+		std::vector<uint64_t> seen(m_rowWords);
 		for (const Update& update : m_updates)
 		{
-			if (IsUpdateValid(update))
+			if (IsUpdateValid(update, seen.data()))
 			{
-				sum += update.input[update.input.size() / 2];
-				continue;
+				sum += m_pageValues[m_updatePages[update.offset + update.count / 2]];
 			}
 		}
 
@@ -130,45 +176,17 @@ private:
 	{
 		// Part Two
 		int sum = 0;
-		std::vector<int> temp;
+		std::vector<uint64_t> scratch(m_rowWords);
+		std::vector<uint32_t> inDegree(m_pageValues.size());
+		std::vector<uint32_t> ready;
 		for (const Update& update : m_updates)
 		{
-			if (IsUpdateValid(update))
+			if (IsUpdateValid(update, scratch.data()))
 			{
 				continue;
 			}
 
-			temp.clear();
-			temp.reserve(update.input.size());
-			temp.insert(temp.begin(), update.input.begin(), update.input.end());
-			std::sort(temp.begin(), temp.end(), [&, this](const int LHS, const int RHS)
-				{
-					int LHSpageIndex = GetRuleIndexForPage(LHS); 
-					int RHSpageIndex = GetRuleIndexForPage(RHS);
-						
-					if (LHSpageIndex != -1) // See if A must come before B
-					{
-						const Rule& LHSRule = m_rules[LHSpageIndex];
-						if (LHSRule.before.find(RHS) != LHSRule.before.end())
-						{
-							return true;
-						}
-					}
-
-					if (RHSpageIndex != -1)
-					{
-						const Rule& RHSRule = m_rules[RHSpageIndex];
-						if (RHSRule.before.find(LHS) != RHSRule.before.end()) // If B must come before A
-						{
-							return false;
-						}
-					}
-
-					// Default, no rules so they are fine.
-					return LHS < RHS;
-				});
-
-			sum += temp[temp.size() / 2];
+			sum += m_pageValues[GetReorderedMiddlePage(update, scratch.data(), inDegree, ready)];
 		}
 
 		Log("Sum = %d", sum);
@@ -177,7 +195,12 @@ private:
 		AdventGUIInstance::PartTwo(context);
 	}
 
-	std::vector<Rule> m_rules;
+	std::unordered_map<int, uint32_t> m_pageIndices; // Page number -> dense index, only needed while parsing.
+	std::vector<int> m_pageValues;                    // Dense index -> page number.
+	uint32_t m_rowWords = 0;
+	std::vector<uint64_t> m_precedes;
+	std::vector<uint64_t> m_follows;                  // Transpose of m_precedes.
+	std::vector<uint32_t> m_updatePages;
 	std::vector<Update> m_updates;
 
 };
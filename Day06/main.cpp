@@ -1,7 +1,8 @@
 #include "AdventGUI/AdventGUI.h"
-#include <ACUtils/IntVec.h>
 #include <ACUtils/Math.h>
-#include <unordered_set>
+#include <ACUtils/Parallel.h>
+#include <atomic>
+#include <climits>
 
 class AdventDay : public AdventGUIInstance
 {
@@ -13,10 +14,13 @@ private:
 	{
 		// Parse Input. Input never changes between parts of a problem.
 		std::string line;
-		std::vector<std::string> tokens;
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
+			if (line.empty())
+			{
+				continue;
+			}
 
 			if (m_MapWidth == 0)
 			{
@@ -30,8 +34,7 @@ private:
 			size_t startLocIdx = line.find('^');
 			if (startLocIdx != std::string::npos)
 			{
-				m_StartPos.x = (int)startLocIdx;
-				m_StartPos.y = (int)m_Map.size() / m_MapWidth;
+				m_StartCell = (int)(m_Map.size() + startLocIdx);
 				line[startLocIdx] = '.';
 			}
 			
@@ -39,81 +42,153 @@ private:
 		}
 
 		m_MapHeight = (int)m_Map.size() / m_MapWidth;
+		BuildJumpTables();
 	}
 
-	bool IsValidPos(const IntVec2& pos) const { return m_Map[pos.y * m_MapWidth + pos.x] == '.'; }
+	// Up, right, down, left. Turning right is dir + 1.
+	static constexpr int DIR_X[4] = { 0, 1, 0, -1 };
+	static constexpr int DIR_Y[4] = { -1, 0, 1, 0 };
+	enum : int { EXIT_CELL = -1 };
+
+	bool IsBlocked(int x, int y) const { return m_Map[y * m_MapWidth + x] == '#'; }
 
-	bool CanLeaveMap(const std::string& mapData, uint64_t& outPathHash) const
+	// m_Jumps[dir][cell] is the last cell the guard reaches walking from cell in dir before hitting an obstacle, or
+	// EXIT_CELL if they walk off the map. Each direction is filled by sweeping against it.
+	void BuildJumpTables()
 	{
-		std::unordered_set<IntVec4> history;
+		const int numCells = m_MapWidth * m_MapHeight;
+		for (int dir = 0; dir < 4; ++dir)
+		{
+			m_Jumps[dir].assign(numCells, EXIT_CELL);
+			const bool reverseY = DIR_Y[dir] > 0;
+			const bool reverseX = DIR_X[dir] > 0;
+			for (int row = 0; row < m_MapHeight; ++row)
+			{
+				const int y = reverseY ? m_MapHeight - 1 - row : row;
+				for (int col = 0; col < m_MapWidth; ++col)
+				{
+					const int x = reverseX ? m_MapWidth - 1 - col : col;
+					const int nextX = x + DIR_X[dir];
+					const int nextY = y + DIR_Y[dir];
+					int& jump = m_Jumps[dir][y * m_MapWidth + x];
+					if (nextX < 0 || nextY < 0 || nextX >= m_MapWidth || nextY >= m_MapHeight)
+					{
+						jump = EXIT_CELL;
+					}
+					else if (IsBlocked(nextX, nextY))
+					{
+						jump = y * m_MapWidth + x;
+					}
+					else
+					{
+						jump = m_Jumps[dir][nextY * m_MapWidth + nextX];
+					}
+				}
+			}
+		}
+	}
 
-		IntVec2 currPos = m_StartPos;
-		IntVec2 nextPos = currPos;
-		IntVec2 cwDir[4] = { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
-		int dirIdx = 0; // Always start facing "up" which is -1 since we are in a top to bottom array.
-		while (true)
+	// Jump table lookup, patched for one extra obstacle: if it sits on the line between cell and the table's answer the
+	// guard stops just short of it instead.
+	int Move(int cell, int dir, int obstacleCell) const
+	{
+		const int target = m_Jumps[dir][cell];
+		const int x = cell % m_MapWidth;
+		const int y = cell / m_MapWidth;
+		const int obstacleX = obstacleCell % m_MapWidth;
+		const int obstacleY = obstacleCell / m_MapWidth;
+
+		int obstacleDist = 0;
+		if (DIR_X[dir] == 0 && obstacleX == x)
+		{
+			obstacleDist = (obstacleY - y) * DIR_Y[dir];
+		}
+		else if (DIR_Y[dir] == 0 && obstacleY == y)
 		{
-			history.insert(IntVec4(currPos.x, currPos.y, cwDir[dirIdx].x, cwDir[dirIdx].y));
+			obstacleDist = (obstacleX - x) * DIR_X[dir];
+		}
 
-			nextPos = currPos + cwDir[dirIdx];
+		if (obstacleDist <= 0)
+		{
+			return target;
+		}
 
-			if (nextPos.x < 0 || nextPos.y < 0 || nextPos.x >= m_MapWidth || nextPos.y >= m_MapHeight)
-			{
-				// left the area.
-				return true;
-			}
+		const int targetDist = target == EXIT_CELL ? INT_MAX : abs(target % m_MapWidth - x) + abs(target / m_MapWidth - y);
+		if (obstacleDist > targetDist)
+		{
+			return target;
+		}
 
-			if (mapData[nextPos.y * m_MapWidth + nextPos.x] == '#') // Blocked?
+		return obstacleCell - (DIR_Y[dir] * m_MapWidth + DIR_X[dir]);
+	}
+
+	// Walks turn to turn with the extra obstacle in place. Only the cells the guard turns in are stamped, revisiting one
+	// facing the same way means a loop.
+	bool IsLoop(int cell, int dir, int obstacleCell, std::vector<uint32_t>& stamps, uint32_t generation) const
+	{
+		while (true)
+		{
+			cell = Move(cell, dir, obstacleCell);
+			if (cell == EXIT_CELL)
 			{
-				dirIdx = (dirIdx + 1) & 3; // %4;
-				nextPos = currPos;
+				return false;
 			}
 
-			currPos = nextPos;
-
-			if (history.find(IntVec4(currPos.x, currPos.y, cwDir[dirIdx].x, cwDir[dirIdx].y)) != history.end())
+			dir = (dir + 1) & 3;
+			uint32_t& stamp = stamps[cell * 4 + dir];
+			if (stamp == generation)
 			{
-				outPathHash = 0;
-				for (const IntVec4& pathHistory : history)
-				{
-					outPathHash += pathHistory.ToHash();
-				}
-				return false;
+				return true;
 			}
+			stamp = generation;
 		}
-
-		return false;
 	}
 
+	// First time the original path enters a cell, and the state it was in on the step before.
+	struct Candidate
+	{
+		int cell;
+		int fromCell;
+		int fromDir;
+	};
+
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
-		IntVec2 currPos = m_StartPos;
-		IntVec2 nextPos = currPos;
+		std::vector<uint8_t> visited(m_Map.size(), 0);
+		m_Candidates.clear();
 
-		IntVec2 cwDir[4] = { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
-		int dirIdx = 0; // Always start facing "up" which is -1 since we are in a top to bottom array.
+		int cell = m_StartCell;
+		int dir = 0; // Always start facing "up" which is -1 since we are in a top to bottom array.
+		visited[cell] = 1;
+		size_t uniqueSteps = 1;
 		while (true)
 		{
-			m_path.insert(currPos);
-
-			nextPos = currPos + cwDir[dirIdx];
-
-			if (nextPos.x < 0 || nextPos.y < 0 || nextPos.x >= m_MapWidth || nextPos.y >= m_MapHeight)
+			const int nextX = cell % m_MapWidth + DIR_X[dir];
+			const int nextY = cell / m_MapWidth + DIR_Y[dir];
+			if (nextX < 0 || nextY < 0 || nextX >= m_MapWidth || nextY >= m_MapHeight)
 			{
 				// left the area.
 				break;
 			}
 
-			if (!IsValidPos(nextPos)) // Blocked?
+			if (IsBlocked(nextX, nextY))
 			{
-				dirIdx = (dirIdx + 1) & 3; // %4;
+				dir = (dir + 1) & 3; // %4;
+				continue;
 			}
 
-			currPos = nextPos;
+			const int nextCell = nextY * m_MapWidth + nextX;
+			if (!visited[nextCell])
+			{
+				visited[nextCell] = 1;
+				m_Candidates.push_back({ nextCell, cell, dir });
+				++uniqueSteps;
+			}
+			cell = nextCell;
 		}
 
-		Log("Unique steps = %zd", m_path.size());
+		Log("Unique steps = %zd", uniqueSteps);
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
@@ -122,45 +197,57 @@ private:
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
-		std::string candidateMap;
-		std::unordered_set<uint64_t> variations;
-		uint64_t pathCrc = 0;
-		for (const IntVec2 tile : m_path)
+		// Only cells on the original path can change anything. The guard's route up to the first time it reaches one is
+		// the same with or without an obstacle there, so each candidate starts from the step before that.
+		struct ThreadScratch
 		{
-			if (tile == m_StartPos)
+			std::vector<uint32_t> stamps; // Generation stamped (cell, dir) turn states, never cleared.
+			uint32_t generation = 0;
+		};
+
+		std::vector<ThreadScratch> scratch(Parallel::GetNumThreads());
+		std::atomic<uint32_t> variations(0);
+		Parallel::For(m_Candidates.size(), 64, [&](uint32_t threadIndex, size_t begin, size_t end)
+		{
+			ThreadScratch& threadScratch = scratch[threadIndex];
+			if (threadScratch.stamps.empty())
 			{
-				continue;
+				threadScratch.stamps.resize(m_Map.size() * 4, 0);
 			}
 
-			candidateMap = m_Map;
-			candidateMap[tile.y * m_MapWidth + tile.x] = '#';
-			
-			if (!CanLeaveMap(candidateMap, pathCrc))
+			uint32_t loops = 0;
+			for (size_t i = begin; i < end; ++i)
 			{
-				variations.insert(pathCrc);
+				const Candidate& candidate = m_Candidates[i];
+				loops += IsLoop(candidate.fromCell, candidate.fromDir, candidate.cell, threadScratch.stamps, ++threadScratch.generation) ? 1 : 0;
 			}
-		}
+			variations.fetch_add(loops);
+		});
 
-		Log("Variations = %zd", variations.size());
+		Log("Variations = %u", variations.load());
 
 		// Done.
 		AdventGUIInstance::PartTwo(context);
 	}
 
-	IntVec2 m_StartPos;
-	int m_MapWidth;
-	int m_MapHeight;
+	int m_StartCell = 0;
+	int m_MapWidth = 0;
+	int m_MapHeight = 0;
 	std::string m_Map;
-	std::unordered_set<IntVec2> m_path; // for Part 2
+	std::vector<int> m_Jumps[4];
+	std::vector<Candidate> m_Candidates; // for Part 2
 
 };
 
+constexpr int AdventDay::DIR_X[4];
+constexpr int AdventDay::DIR_Y[4];
+
 int main()
 {
 	AdventGUIParams newParams;
 	newParams.day = 6;
 	newParams.year = 2024;
-	newParams.puzzleTitle = "Print Queue";
+	newParams.puzzleTitle = "Guard Gallivant";
 	newParams.inputFilename = "input.txt";
 
 	AdventGUIInstance::InstantiateAndExecute<AdventDay>(newParams);
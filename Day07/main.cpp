@@ -1,4 +1,7 @@
 #include "AdventGUI/AdventGUI.h"
+#include "ACUtils/Math.h"
+#include "ACUtils/Parallel.h"
+#include <atomic>
 
 class AdventDay : public AdventGUIInstance
 {
@@ -6,52 +9,73 @@ public:
 	AdventDay(const AdventGUIParams& params) : AdventGUIInstance(params) {};
 
 private:
-	enum class InputOp : uint8_t
-	{
-		InputOp_Add = 0,
-		InputOp_Mul,
-		InputOp_Concat
-	};
-
+	// Readings are stored back to back in m_readings, with the power of ten each one shifts by when concatenated.
 	struct Calibration
 	{
-		uint64_t targetValue;
-		std::vector<uint32_t> readings;
+		uint64_t targetValue = 0;
+		uint32_t offset = 0;
+		uint32_t count = 0;
 	};
 
 	virtual void ParseInput(FileStreamReader& fileReader) override
 	{
 		// Parse Input. Input never changes between parts of a problem.
 		std::string line;
-		std::vector<std::string> tokens;
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
-			StringUtil::SplitBy(line, ":| ", tokens);
+			if (line.empty())
+			{
+				continue;
+			}
+
+			const char* cursor = line.c_str();
+			char* next = nullptr;
 			Calibration newCalibration;
-			newCalibration.targetValue = StringUtil::AtoiU64(tokens[0].c_str());
-			for (size_t i = 1; i < tokens.size(); ++i)
+			newCalibration.targetValue = strtoull(cursor, &next, 10);
+			newCalibration.offset = (uint32_t)m_readings.size();
+			cursor = next + 1; // ':'
+			for (uint64_t value = strtoull(cursor, &next, 10); next != cursor; value = strtoull(cursor, &next, 10))
 			{
-				newCalibration.readings.push_back((uint32_t)atoi(tokens[i].c_str()));
+				// 10^20 doesn't fit in 64 bits, so 20 digit readings get a scale of 0 standing in for it.
+				const uint32_t digits = Math::CountDigits(value);
+				m_readings.push_back(value);
+				m_readingScales.push_back(digits <= 19 ? Math::Pow10(digits) : 0);
+				cursor = next;
 			}
+			newCalibration.count = (uint32_t)m_readings.size() - newCalibration.offset;
+			assert(newCalibration.count > 0);
 
 			m_calibrations.emplace_back(newCalibration);
 		}
 	}
 
-	bool IsValidCalibration(const Calibration& calib, bool allowConcat = false) const
+	// Works backwards from the target: the last reading was either added (subtract it), multiplied (it has to divide
+	// exactly) or concatenated (it has to be the target's decimal suffix). Most branches die immediately, and every
+	// intermediate is smaller than the target so nothing can overflow.
+	bool CanSolve(uint64_t target, const uint64_t* readings, const uint64_t* scales, uint32_t count, bool allowConcat) const
 	{
-		if (RecursiveCheck(calib, 1, calib.readings[0], InputOp::InputOp_Add, allowConcat))
+		const uint64_t last = readings[count - 1];
+		if (count == 1)
+		{
+			return target == last;
+		}
+
+		if (target >= last && CanSolve(target - last, readings, scales, count - 1, allowConcat))
 		{
 			return true;
 		}
-		
-		if (RecursiveCheck(calib, 1, calib.readings[0], InputOp::InputOp_Mul, allowConcat))
+
+		if (last == 0 ? target == 0 : (target % last == 0 && CanSolve(target / last, readings, scales, count - 1, allowConcat)))
 		{
 			return true;
 		}
 
-		if (allowConcat && RecursiveCheck(calib, 1, calib.readings[0], InputOp::InputOp_Concat, allowConcat))
+		// A scale of 0 is 10^20, which every target is below: the suffix is the whole target and the prefix is 0.
+		const uint64_t scale = scales[count - 1];
+		const uint64_t suffix = scale ? target % scale : target;
+		const uint64_t prefix = scale ? target / scale : 0;
+		if (allowConcat && target >= last && suffix == last && CanSolve(prefix, readings, scales, count - 1, allowConcat))
 		{
 			return true;
 		}
@@ -59,68 +83,33 @@ private:
 		return false;
 	}
 
-	bool RecursiveCheck(const Calibration& calib, int index, uint64_t current, InputOp op, bool allowConcat) const
+	bool IsValidCalibration(const Calibration& calib, bool allowConcat = false) const
 	{
-		if (index >= (int)calib.readings.size())
-		{
-			 return current == calib.targetValue;
-		}
-
-		if (current > calib.targetValue)
-		{
-			return false;
-		}
-
-		if (op == InputOp::InputOp_Mul && (~0ULL / calib.readings[index]) < current)
-		{
-			return false;
-		}
-
-		uint64_t newCurrent = current;
-		switch (op)
-		{
-			 case InputOp::InputOp_Add: newCurrent += (uint64_t)calib.readings[index]; break;
-			 case InputOp::InputOp_Mul: newCurrent *= (uint64_t)calib.readings[index]; break;
-			 case InputOp::InputOp_Concat:
-			 {
-				 char concatBuf[64] = { '\0' };
-				 sprintf_s(concatBuf, "%llu%llu", current, (uint64_t)calib.readings[index]);
-				 newCurrent = StringUtil::AtoiU64(concatBuf);
-			 }
-		}
-
-		//return RecursiveCheck(calib, index + 1, newCurrent, InputOp::InputOp_Add) + RecursiveCheck(calib, index + 1, newCurrent, InputOp::InputOp_Mul);
-		if (RecursiveCheck(calib, index + 1, newCurrent, InputOp::InputOp_Add, allowConcat))
-		{
-			return true;
-		}
-
-		if (RecursiveCheck(calib, index + 1, newCurrent, InputOp::InputOp_Mul, allowConcat))
-		{
-			return true;
-		}
+		return CanSolve(calib.targetValue, m_readings.data() + calib.offset, m_readingScales.data() + calib.offset, calib.count, allowConcat);
+	}
 
-		if (allowConcat && RecursiveCheck(calib, index + 1, newCurrent, InputOp::InputOp_Concat, allowConcat))
+	uint64_t SumValidCalibrations(bool allowConcat) const
+	{
+		std::atomic<uint64_t> sum(0);
+		Parallel::For(m_calibrations.size(), 64, [&](uint32_t, size_t begin, size_t end)
 		{
-			return true;
-		}
+			uint64_t localSum = 0;
+			for (size_t i = begin; i < end; ++i)
+			{
+				localSum += IsValidCalibration(m_calibrations[i], allowConcat) ? m_calibrations[i].targetValue : 0;
+			}
+			sum.fetch_add(localSum);
+		});
 
-		return false;
+		return sum.load();
 	}
+
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
+		uint64_t sum = SumValidCalibrations(false);
 
-		uint64_t sum = 0;
-		for (const Calibration& calib : m_calibrations)
-		{
-			if (IsValidCalibration(calib) != 0)
-			{
-				sum += calib.targetValue;
-			}			
-		}
-
-		Log("Sum = %u", sum);
+		Log("Sum = %llu", sum);
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
@@ -129,21 +118,16 @@ private:
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
-		uint64_t sum = 0;
-		for (const Calibration& calib : m_calibrations)
-		{
-			if (IsValidCalibration(calib, true) != 0)
-			{
-				sum += calib.targetValue;
-			}
-		}
+		uint64_t sum = SumValidCalibrations(true);
 
-		Log("Sum = %u", sum);
+		Log("Sum = %llu", sum);
 		// Done.
 		AdventGUIInstance::PartTwo(context);
 	}
 
 	std::vector<Calibration> m_calibrations;
+	std::vector<uint64_t> m_readings;
+	std::vector<uint64_t> m_readingScales;
 };
 
 int main()
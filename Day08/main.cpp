@@ -1,7 +1,7 @@
 #include "AdventGUI/AdventGUI.h"
-#include <ACUtils/Algorithm.h>
+#include <ACUtils/Bit.h>
 #include <ACUtils/IntVec.h>
-#include <unordered_set>
+#include <ACUtils/Parallel.h>
 
 class AdventDay : public AdventGUIInstance
 {
@@ -9,45 +9,40 @@ public:
 	AdventDay(const AdventGUIParams& params) : AdventGUIInstance(params) {};
 
 private:
-	struct Antenna
-	{
-		std::vector<IntVec2> Locations;
-		char Frequency;
-	};
-
 	virtual void ParseInput(FileStreamReader& fileReader) override
 	{
 		// Parse Input. Input never changes between parts of a problem.
 		std::string line;
 		m_mapWidth = 0;
+		m_mapHeight = 0;
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
+			if (line.empty())
+			{
+				continue;
+			}
+
 			if (m_mapWidth == 0)
 			{
 				m_mapWidth = (int)line.size();
 			}
 			assert(m_mapWidth == (int)line.size());
 
-			for(size_t i = 0; i < line.size(); ++i)
+			for (size_t i = 0; i < line.size(); ++i)
 			{
 				if (line[i] != '.')
 				{
-					int existingAntenna = Algorithm::find_index_of(m_antennas.begin(), m_antennas.end(), [&](const Antenna& LHS) { return LHS.Frequency == line[i]; });
-					if (existingAntenna < 0)
+					std::vector<IntVec2>& locations = m_antennas[(uint8_t)line[i]];
+					if (locations.empty())
 					{
-						m_antennas.emplace_back();
-						existingAntenna = (int)m_antennas.size() - 1;
-						m_antennas[existingAntenna].Frequency = line[i];
+						m_frequencies.push_back((uint8_t)line[i]);
 					}
-					assert(existingAntenna >= 0);
-					m_antennas[existingAntenna].Locations.emplace_back((int)i, (int)m_mapData.size() / m_mapWidth);
+					locations.emplace_back((int)i, m_mapHeight);
 				}
-				m_mapData.push_back(line[i]);
 			}
+			++m_mapHeight;
 		}
-
-		m_mapHeight = (int)m_mapData.size() / m_mapWidth;
 	}
 
 	bool IsInBounds(const IntVec2& pos) const
@@ -59,45 +54,94 @@ private:
 
 		return true;
 	}
-	virtual void PartOne(const AdventGUIContext& context) override
+
+	static void SetBit(std::vector<uint64_t>& bits, uint32_t index)
 	{
-		// Part One
-		std::unordered_set<IntVec2> antiNodes;
+		bits[index / 64] |= 1ULL << (index % 64);
+	}
+
+	// Work is split per antenna rather than per frequency so one huge frequency still spreads across threads. Each thread
+	// marks antinodes in its own grid bitset, and they're OR'd together at the end.
+	size_t CountAntinodes(bool resonantHarmonics) const
+	{
+		struct WorkItem
+		{
+			uint8_t frequency;
+			uint32_t antenna;
+		};
 
-		IntVec2 delta;
-		IntVec2 candidateA;
-		IntVec2 candidateB;
-		for (const Antenna& antenna : m_antennas)
+		std::vector<WorkItem> work;
+		for (uint8_t frequency : m_frequencies)
 		{
-			for (size_t i = 0; i < antenna.Locations.size(); ++i)
+			for (uint32_t i = 0; i < (uint32_t)m_antennas[frequency].size(); ++i)
 			{
-				IntVec2 A = antenna.Locations[i];
-				for (size_t j = i + 1; j < antenna.Locations.size(); ++j)
+				work.push_back({ frequency, i });
+			}
+		}
+
+		const size_t numWords = Bits::BitArraySize64((size_t)m_mapWidth * m_mapHeight);
+		std::vector<std::vector<uint64_t>> threadAntinodes(Parallel::GetNumThreads());
+		Parallel::For(work.size(), 16, [&](uint32_t threadIndex, size_t begin, size_t end)
+		{
+			std::vector<uint64_t>& antinodes = threadAntinodes[threadIndex];
+			antinodes.resize(numWords, 0ULL);
+
+			for (size_t w = begin; w < end; ++w)
+			{
+				const std::vector<IntVec2>& locations = m_antennas[work[w].frequency];
+				const IntVec2 A = locations[work[w].antenna];
+				for (size_t j = work[w].antenna + 1; j < locations.size(); ++j)
 				{
-					IntVec2 B = antenna.Locations[j];
-					delta = B - A;
-					if (A + delta == B)
+					const IntVec2 B = locations[j];
+					const IntVec2 delta = B - A;
+					if (resonantHarmonics)
+					{
+						for (IntVec2 candidate = A; IsInBounds(candidate); candidate -= delta)
+						{
+							SetBit(antinodes, candidate.y * m_mapWidth + candidate.x);
+						}
+						for (IntVec2 candidate = B; IsInBounds(candidate); candidate += delta)
+						{
+							SetBit(antinodes, candidate.y * m_mapWidth + candidate.x);
+						}
+					}
+					else
 					{
-						candidateA = A - delta;
-						assert(B - delta == A);
-						candidateB = B + delta;
-						// A'
+						const IntVec2 candidateA = A - delta;
+						const IntVec2 candidateB = B + delta;
 						if (IsInBounds(candidateA))
 						{
-							antiNodes.insert(candidateA);
+							SetBit(antinodes, candidateA.y * m_mapWidth + candidateA.x);
 						}
-						// B'
 						if (IsInBounds(candidateB))
 						{
-							antiNodes.insert(candidateB);
+							SetBit(antinodes, candidateB.y * m_mapWidth + candidateB.x);
 						}
-					}		
+					}
 				}
 			}
+		});
+
+		size_t total = 0;
+		for (size_t i = 0; i < numWords; ++i)
+		{
+			uint64_t word = 0;
+			for (const std::vector<uint64_t>& antinodes : threadAntinodes)
+			{
+				word |= antinodes.empty() ? 0ULL : antinodes[i];
+			}
+			total += Bits::PopCount64(word);
 		}
 
-		Log("Total Antinodes = %zd", antiNodes.size());
+		return total;
+	}
+
+	virtual void PartOne(const AdventGUIContext& context) override
+	{
+		// Part One
+		size_t antiNodes = CountAntinodes(false);
 
+		Log("Total Antinodes = %zd", antiNodes);
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
@@ -106,53 +150,17 @@ private:
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
-		std::unordered_set<IntVec2> antiNodes;
-
-		IntVec2 delta;
-		IntVec2 candidateA;
-		IntVec2 candidateB;
-		for (const Antenna& antenna : m_antennas)
-		{
-			for (size_t i = 0; i < antenna.Locations.size(); ++i)
-			{
-				IntVec2 A = antenna.Locations[i];
-				for (size_t j = i + 1; j < antenna.Locations.size(); ++j)
-				{
-					IntVec2 B = antenna.Locations[j];
-					delta = B - A;
-					if (A + delta == B)
-					{
-						antiNodes.insert(A);
-						antiNodes.insert(B);
-
-						candidateA = A - delta;
-						assert(B - delta == A);
-						candidateB = B + delta;
-						// A'
-						while (IsInBounds(candidateA))
-						{
-							antiNodes.insert(candidateA);
-							candidateA -= delta;
-						}
-						// B'
-						while (IsInBounds(candidateB))
-						{
-							antiNodes.insert(candidateB);
-							candidateB += delta;
-						}
-					}
-				}
-			}
-		}
+		size_t antiNodes = CountAntinodes(true);
 
-		Log("Total Antinodes = %zd", antiNodes.size());
+		Log("Total Antinodes = %zd", antiNodes);
 		// Done.
 		AdventGUIInstance::PartTwo(context);
 	}
+
 	int m_mapWidth;
 	int m_mapHeight;
-	std::string m_mapData;
-	std::vector<Antenna> m_antennas;
+	std::vector<IntVec2> m_antennas[256]; // Indexed by frequency character.
+	std::vector<uint8_t> m_frequencies;   // Frequencies in use, in the order they were found.
 };
 
 int main()
@@ -1,4 +1,5 @@
 #include "AdventGUI/AdventGUI.h"
+#include "ACUtils/Int128.h"
 
 class AdventDay : public AdventGUIInstance
 {
@@ -6,179 +7,127 @@ public:
 	AdventDay(const AdventGUIParams& params) : AdventGUIInstance(params) {};
 
 private:
+	struct Span
+	{
+		uint32_t offset;
+		uint32_t size;
+	};
 
 	virtual void ParseInput(FileStreamReader& fileReader) override
 	{
 		// Parse Input. Input never changes between parts of a problem.
+		// Digits alternate file, free, file, ... File ids are their index in m_files, m_gaps[i] follows file i.
 		std::string line;
+		uint32_t offset = 0;
+		bool isFile = true;
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
-			m_input.append(line);
+			m_files.reserve(m_files.size() + line.size() / 2 + 1);
+			m_gaps.reserve(m_gaps.size() + line.size() / 2 + 1);
+			for (char digit : line)
+			{
+				const Span span = { offset, (uint32_t)(digit - '0') };
+				(isFile ? m_files : m_gaps).push_back(span);
+				offset += span.size;
+				isFile = !isFile;
+			}
 		}
+		m_gaps.resize(m_files.size(), Span{ offset, 0 });
+	}
 
+	// Checksum contribution of id stored in size consecutive blocks starting at offset, without visiting each block.
+	// Totals for maps in the tens of millions of digits outgrow 64 bits, so sums are kept in 128.
+	static UInt128 SpanChecksum(uint64_t id, uint64_t offset, uint64_t size)
+	{
+		return UInt128::Multiply(id, size * offset + size * (size - 1) / 2);
 	}
 
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
-		std::vector<uint32_t> expandedBlocks;
-		expandedBlocks.reserve(m_input.size() * 9);
-		uint32_t currentId = 0;
-		uint32_t numBlocks = 0;
-		std::string::const_iterator itIter = m_input.begin();
-		while (itIter != m_input.end())
-		{
-			// ID
-			expandedBlocks.insert(expandedBlocks.end(), *itIter - '0', currentId++);
-			++itIter;
-
-			if (itIter == m_input.end())
-			{
-				break;
-			}
-
-			expandedBlocks.insert(expandedBlocks.end(), *itIter - '0', ~0U);
-			++itIter;
-		}
-
-		size_t i = 0;
-		size_t j = expandedBlocks.size() -1;
-		while (true)
+		// Walk the files left to right, filling each gap from the back of the rightmost unmoved file.
+		UInt128 totalSum;
+		if (!m_files.empty())
 		{
-			if (i >= j)
-			{
-				break;
-			}
-
-			if (expandedBlocks[i] != ~0U)
-			{
-				++i;
-			}
-			else if (expandedBlocks[j] == ~0U)
+			uint64_t position = 0;
+			size_t right = m_files.size() - 1;
+			uint32_t rightRemaining = m_files[right].size;
+			for (size_t left = 0; left <= right; ++left)
 			{
-				--j;
-			}
-			else
-			{
-				std::swap(expandedBlocks[i], expandedBlocks[j]);
-			}
-		}
+				const uint32_t fileSize = left == right ? rightRemaining : m_files[left].size;
+				totalSum += SpanChecksum(left, position, fileSize);
+				position += fileSize;
 
-		uint64_t totalSum = 0;
-		for (size_t i = 0; i < expandedBlocks.size(); ++i)
-		{
-			if (expandedBlocks[i] == ~0U)
-			{
-				break;
+				uint32_t freeBlocks = m_gaps[left].size;
+				while (freeBlocks > 0 && right > left)
+				{
+					const uint32_t moved = std::min(freeBlocks, rightRemaining);
+					totalSum += SpanChecksum(right, position, moved);
+					position += moved;
+					freeBlocks -= moved;
+					rightRemaining -= moved;
+					if (rightRemaining == 0)
+					{
+						--right;
+						rightRemaining = m_files[right].size;
+					}
+				}
 			}
-
-			totalSum += expandedBlocks[i] * (uint64_t)i;
 		}
 
-		Log("Total Sum = %llu", totalSum);
+		char totalBuffer[48];
+		Log("Total Sum = %s", totalSum.ToString(totalBuffer, sizeof(totalBuffer)));
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
 	}
 
-	struct FileSector
-	{
-		FileSector(int _id, int _size)
-		: id(static_cast<uint32_t>(_id)),
-		size(static_cast<uint16_t>(_size))
-		{
-		}
-
-		uint32_t id;
-		uint16_t size;
-	};
-
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
-		std::vector<FileSector> expandedBlocks;
-		expandedBlocks.reserve(m_input.size() * 9);
-		uint32_t currentId = 0;
-		uint32_t numBlocks = 0;
-		std::string::const_iterator itIter = m_input.begin();
-		while (itIter != m_input.end())
-		{
-			// ID
-			expandedBlocks.push_back(FileSector(currentId++, *itIter - '0'));
-			++itIter;
-
-			if (itIter == m_input.end())
-			{
-				break;
-			}
-
-			expandedBlocks.push_back(FileSector(~0U, *itIter - '0'));
-			++itIter;
-		}
-
-		size_t i = 0;
-		size_t j = expandedBlocks.size() - 1;
-		while (i < expandedBlocks.size())
+		// A file of size s goes in the leftmost gap with at least s free blocks. Gaps only ever shrink, so the leftmost
+		// gap that fits s never moves left and one cursor per size walks m_gaps at most once over the whole pass.
+		// Space a file moves out of is never reused, everything still to move sits further left.
+		static constexpr uint32_t MAX_SPAN_SIZE = 9;
+		std::vector<Span> gaps = m_gaps;
+		size_t cursors[MAX_SPAN_SIZE + 1] = {};
+
+		UInt128 totalSum;
+		for (size_t id = m_files.size(); id-- > 0;)
 		{
-			if (expandedBlocks[i].id != ~0U)
-			{
-				++i;
-			}
-			else if (expandedBlocks[j].id == ~0U || expandedBlocks[j].size > expandedBlocks[i].size)
+			const Span& file = m_files[id];
+			uint64_t fileOffset = file.offset;
+			if (file.size > 0)
 			{
-				if (j <= i)
+				size_t& cursor = cursors[file.size];
+				while (cursor < id && gaps[cursor].size < file.size)
 				{
-					++i;
-					j = expandedBlocks.size() - 1;
+					++cursor;
 				}
-				else
-				{
-					--j;
-				}
-			}
-			else
-			{
-				if (expandedBlocks[i].size == expandedBlocks[j].size) // Same size, just swap.
-				{
-					std::swap(expandedBlocks[i], expandedBlocks[j]);
-				}
-				else
-				{
-					FileSector remainder(~0U, expandedBlocks[i].size - expandedBlocks[j].size);
-					std::swap(expandedBlocks[i], expandedBlocks[j]);
-					expandedBlocks[j].id = ~0U;
-					expandedBlocks[j].size = expandedBlocks[i].size;
-					expandedBlocks.insert(expandedBlocks.begin() + i + 1, remainder);
-				}
-
-				j = expandedBlocks.size() - 1;
-			}
-		}
 
-		uint64_t totalSum = 0;
-		uint64_t offset = 0;
-		for (size_t i = 0; i < expandedBlocks.size(); ++i)
-		{
-			const FileSector& currentFile = expandedBlocks[i];
-			if (currentFile.id != ~0U)
-			{
-				for (size_t j = 0; j < currentFile.size; ++j)
+				// Gap i sits right after file i, so only gaps before this file are to its left.
+				if (cursor < id)
 				{
-					totalSum += currentFile.id * (offset + j);
+					Span& gap = gaps[cursor];
+					fileOffset = gap.offset;
+					gap.offset += file.size;
+					gap.size -= file.size;
 				}
 			}
 
-			offset += currentFile.size;
+			totalSum += SpanChecksum(id, fileOffset, file.size);
 		}
 
-		Log("Total Sum = %llu", totalSum);
+		char totalBuffer[48];
+		Log("Total Sum = %s", totalSum.ToString(totalBuffer, sizeof(totalBuffer)));
 
 		// Done.
 		AdventGUIInstance::PartTwo(context);
 	}
 
-	std::string m_input;
+	std::vector<Span> m_files;
+	std::vector<Span> m_gaps;
 };
 
 int main()
@@ -1,8 +1,5 @@
 #include "AdventGUI/AdventGUI.h"
-#include "ACUtils/BDFS.h"
-#include "ACUtils/IntVec.h"
-#include <unordered_set>
-#include "imgui.h"
+#include <algorithm>
 
 class AdventDay : public AdventGUIInstance
 {
@@ -10,119 +7,8 @@ public:
 	AdventDay(const AdventGUIParams& params) : AdventGUIInstance(params), m_mapWidth(0), m_mapHeight(0), m_mapData() {};
 
 private:
-	struct Pathway 
-	{
-		Pathway(const std::vector<IntVec2>& _path)
-		: path(_path)
-		{
-			hash = 0;
-			for (const IntVec2& pt : path)
-			{
-				hash = Hash::HashCombineSize(hash, pt.ToHash());
-			}
-		}
-		std::vector<IntVec2> path;
-		size_t hash;
-	};
-
-	class PathwayNode : public BDFS::BDFSNode<Pathway>
-	{
-	public:
-		PathwayNode(const Pathway& pathway) : BDFSNode(pathway){}
-		virtual size_t GetHash() const { return GetState().hash; }
-	};
-
-	class PathwayExec : public BDFS::BDFSExecuter<Pathway>
-	{
-	public:
-		PathwayExec(size_t mapWidth, const std::vector<int8_t>& mapData):BDFSExecuter(BDFSExecuter::BDFSExecuterMode::BDFSExecuterMode_DepthFirst)
-		{
-			m_mapWidth = mapWidth;
-			m_mapData = mapData;
-			m_mapHeight = m_mapData.size() / m_mapWidth;
-		}
-
-		int8_t GetMapValue(const IntVec2& pos) const
-		{
-			return m_mapData[pos.y * m_mapWidth + pos.x];
-		}
-
-		virtual bool ProcessNode(const BDFS::BDFSNode<Pathway>* node) override
-		{
-			const Pathway& currState = node->GetState();
-
-			if (GetMapValue(currState.path.back()) == 9)
-			{
-				m_solutions.push_back(currState);
-
-				const IntVec2& eightPos = currState.path[8];
-				const IntVec2 dirstwo[] = { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
-
-
-				IntVec4 trailhead(currState.path.front(), currState.path.back());
-
-				auto itFind = m_trailHeads.find(trailhead);
-				if (itFind == m_trailHeads.end())
-				{
-					AdventGUIConsole::Get().Log("Added Trailhead [%d, %d] -> [%d, %d]", trailhead.x, trailhead.y, trailhead.z, trailhead.w);
-					m_trailHeads.insert(trailhead);
-				}
-				else
-				{
-					assert(*itFind == trailhead);
-				}
-
-				return false;
-			}
-
-			const IntVec2 dirs[] = { {0, -1}, {1, 0}, {0, 1}, {-1, 0}};
-			std::vector<IntVec2> newPath;
-			int8_t currValue = 0;
-			int8_t nextValue = 0;
-
-			bool addedNodes = false;
-			for (const IntVec2& off : dirs)
-			{
-				IntVec2 candidatePos = currState.path.back() + off;
-				if (candidatePos.x < 0 || candidatePos.y < 0 || candidatePos.x >= m_mapWidth || candidatePos.y >= m_mapHeight)
-				{
-					continue;
-				}
-
-				currValue = GetMapValue(currState.path.back());
-				nextValue = GetMapValue(candidatePos);
-				int8_t delta = nextValue - currValue;
-
-				if (delta == 1)
-				{
-					assert(currValue + 1 == nextValue);
-					newPath.clear();
-					newPath = currState.path;
-					newPath.push_back(candidatePos);
-
-					Pathway newState(newPath);
-					PathwayNode tmp(newState);
-
-					if (!IsDiscovered(&tmp))
-					{
-						QueueNode(new PathwayNode(newState));
-						addedNodes = true;
-					}
-				}
-			}
-
-			return addedNodes;
-		}
-
-		const std::vector<Pathway>& GetSolutions() const { return m_solutions; }
-		const size_t GetTrailheads() const { return m_trailHeads.size(); }
-	private:
-		size_t m_mapWidth;
-		size_t m_mapHeight;
-		std::vector<int8_t> m_mapData;
-		std::vector<Pathway> m_solutions;
-		std::unordered_set<IntVec4> m_trailHeads;
-	};
+	static constexpr int8_t MAX_HEIGHT = 9;
+	static constexpr int8_t IMPASSABLE = -1;
 
 	virtual void ParseInput(FileStreamReader& fileReader) override
 	{
@@ -132,6 +18,11 @@ private:
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
+			if (line.empty())
+			{
+				continue;
+			}
+
 			if (m_mapWidth == 0)
 			{
 				m_mapWidth = line.size();
@@ -140,33 +31,86 @@ private:
 			
 			for(size_t i = 0; i < line.size(); ++i)
 			{
-				m_mapData.push_back(line[i] - '0');
-
-				if (m_mapData.back() == 0)
+				const bool isHeight = line[i] >= '0' && line[i] <= '9';
+				m_mapData.push_back(isHeight ? (int8_t)(line[i] - '0') : IMPASSABLE);
+				if (isHeight)
 				{
-					m_startLocs.emplace_back((int32_t)i, (int32_t)(m_mapData.size() / m_mapWidth));
+					m_layers[m_mapData.back()].push_back((uint32_t)m_mapData.size() - 1);
 				}
 			}
 		}
 
-		m_mapHeight = m_mapData.size() / m_mapWidth;
+		m_mapHeight = m_mapWidth ? m_mapData.size() / m_mapWidth : 0;
+	}
+
+	// Calls func(neighbour) for every orthogonal neighbour of cell that is exactly one higher.
+	template<typename Func>
+	void ForEachUphillNeighbour(uint32_t cell, Func&& func) const
+	{
+		const size_t x = cell % m_mapWidth;
+		const size_t y = cell / m_mapWidth;
+		const int8_t nextHeight = m_mapData[cell] + 1;
+		const uint32_t width = (uint32_t)m_mapWidth;
+		if (y > 0 && m_mapData[cell - width] == nextHeight)
+		{
+			func(cell - width);
+		}
+		if (x + 1 < m_mapWidth && m_mapData[cell + 1] == nextHeight)
+		{
+			func(cell + 1);
+		}
+		if (y + 1 < m_mapHeight && m_mapData[cell + width] == nextHeight)
+		{
+			func(cell + width);
+		}
+		if (x > 0 && m_mapData[cell - 1] == nextHeight)
+		{
+			func(cell - 1);
+		}
 	}
 
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
-		PathwayExec exec(m_mapWidth, m_mapData);
+		// Layered DP from the summits down. Each cell's reachable summits are the sorted union of its uphill neighbours'
+		// sets. Only two layers are alive at once, each packed into one flat array with [begin, end) ranges per cell.
+		std::vector<uint32_t> listBegin(m_mapData.size(), 0);
+		std::vector<uint32_t> listEnd(m_mapData.size(), 0);
+		std::vector<uint32_t> upperSummits;
+		std::vector<uint32_t> currentSummits;
+
+		for (uint32_t cell : m_layers[MAX_HEIGHT])
+		{
+			listBegin[cell] = (uint32_t)upperSummits.size();
+			upperSummits.push_back(cell);
+			listEnd[cell] = (uint32_t)upperSummits.size();
+		}
 
-		for (const IntVec2& startPos : m_startLocs)
+		for (int8_t height = MAX_HEIGHT - 1; height >= 0; --height)
 		{
-			std::vector<IntVec2> startPath;
-			startPath.push_back(startPos);
-			exec.QueueNode(new PathwayNode(Pathway(startPath)));
+			currentSummits.clear();
+			for (uint32_t cell : m_layers[height])
+			{
+				const uint32_t begin = (uint32_t)currentSummits.size();
+				ForEachUphillNeighbour(cell, [&](uint32_t neighbour)
+				{
+					currentSummits.insert(currentSummits.end(), upperSummits.begin() + listBegin[neighbour], upperSummits.begin() + listEnd[neighbour]);
+				});
+				std::sort(currentSummits.begin() + begin, currentSummits.end());
+				currentSummits.erase(std::unique(currentSummits.begin() + begin, currentSummits.end()), currentSummits.end());
+				listBegin[cell] = begin;
+				listEnd[cell] = (uint32_t)currentSummits.size();
+			}
+			std::swap(upperSummits, currentSummits);
 		}
-		
-		exec.Solve();
 
-		Log("Solutions = %zd", exec.GetTrailheads());
+		size_t score = 0;
+		for (uint32_t cell : m_layers[0])
+		{
+			score += listEnd[cell] - listBegin[cell];
+		}
+
+		Log("Solutions = %zd", score);
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
@@ -175,6 +119,30 @@ private:
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
+		// Same layering, but a cell's rating is just the sum of its uphill neighbours' ratings.
+		std::vector<uint64_t> ratings(m_mapData.size(), 0);
+		for (uint32_t cell : m_layers[MAX_HEIGHT])
+		{
+			ratings[cell] = 1;
+		}
+
+		for (int8_t height = MAX_HEIGHT - 1; height >= 0; --height)
+		{
+			for (uint32_t cell : m_layers[height])
+			{
+				uint64_t rating = 0;
+				ForEachUphillNeighbour(cell, [&](uint32_t neighbour) { rating += ratings[neighbour]; });
+				ratings[cell] = rating;
+			}
+		}
+
+		uint64_t totalRating = 0;
+		for (uint32_t cell : m_layers[0])
+		{
+			totalRating += ratings[cell];
+		}
+
+		Log("Total rating = %llu", totalRating);
 
 		// Done.
 		AdventGUIInstance::PartTwo(context);
@@ -183,7 +151,7 @@ private:
 	size_t m_mapWidth;
 	size_t m_mapHeight;
 	std::vector<int8_t> m_mapData;
-	std::vector<IntVec2> m_startLocs;
+	std::vector<uint32_t> m_layers[MAX_HEIGHT + 1]; // Cells of each height, in row major order.
 };
 
 int main()
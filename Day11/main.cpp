@@ -1,144 +1,515 @@
 #include "AdventGUI/AdventGUI.h"
-#include "ACUtils/Algorithm.h"
 #include "ACUtils/Hash.h"
+#include "ACUtils/Int128.h"
 #include "ACUtils/Math.h"
+#include <array>
 #include <unordered_map>
 
 class AdventDay : public AdventGUIInstance
 {
 public:
-	AdventDay(const AdventGUIParams& params) : AdventGUIInstance(params) {};
+	AdventDay(const AdventGUIParams& params, std::vector<uint64_t> graphQueries)
+		: AdventGUIInstance(params), m_graphQueries(std::move(graphQueries)) {};
 
 private:
+	// Open addressing stone value -> count map. Only the slots in use are touched when clearing or iterating, so a blink
+	// costs the number of distinct values, not the table size.
+	class PebbleMap
+	{
+	public:
+		enum : uint64_t { EMPTY_KEY = ~0ULL };
+
+		PebbleMap() { Rehash(1024); }
+
+		void Add(uint64_t value, const UInt128& count)
+		{
+			assert(value != EMPTY_KEY);
+			if ((m_usedSlots.size() + 1) * 2 > m_keys.size())
+			{
+				Rehash(m_keys.size() * 2);
+			}
+
+			uint32_t slot = (uint32_t)Hash::Hash64(value) & m_mask;
+			while (m_keys[slot] != value && m_keys[slot] != EMPTY_KEY)
+			{
+				slot = (slot + 1) & m_mask;
+			}
+
+			if (m_keys[slot] == EMPTY_KEY)
+			{
+				m_keys[slot] = value;
+				m_counts[slot] = 0;
+				m_usedSlots.push_back(slot);
+			}
+			m_counts[slot] += count;
+			m_hasOverflowed |= m_counts[slot] < count;
+		}
+
+		void Clear()
+		{
+			for (uint32_t slot : m_usedSlots)
+			{
+				m_keys[slot] = EMPTY_KEY;
+			}
+			m_usedSlots.clear();
+			m_hasOverflowed = false;
+		}
 
-	typedef std::unordered_map<uint64_t, uint64_t> PebbleMap;
+		// True if some count wrapped past 2^128 since the last Clear.
+		bool HasOverflowed() const { return m_hasOverflowed; }
+
+		size_t Size() const { return m_usedSlots.size(); }
+
+		template<typename Func>
+		void ForEach(Func&& func) const
+		{
+			for (uint32_t slot : m_usedSlots)
+			{
+				func(m_keys[slot], m_counts[slot]);
+			}
+		}
+
+		// False if the total doesn't fit in 128 bits.
+		bool Total(UInt128& outTotal) const
+		{
+			bool hasOverflowed = m_hasOverflowed;
+			outTotal = 0;
+			ForEach([&](uint64_t, const UInt128& count)
+			{
+				outTotal += count;
+				hasOverflowed |= outTotal < count;
+			});
+			return !hasOverflowed;
+		}
+
+	private:
+		void Rehash(size_t numSlots)
+		{
+			std::vector<uint64_t> oldKeys;
+			std::vector<UInt128> oldCounts;
+			std::vector<uint32_t> oldUsed;
+			oldKeys.swap(m_keys);
+			oldCounts.swap(m_counts);
+			oldUsed.swap(m_usedSlots);
+
+			m_keys.assign(numSlots, EMPTY_KEY);
+			m_counts.resize(numSlots);
+			m_mask = (uint32_t)numSlots - 1;
+			for (uint32_t slot : oldUsed)
+			{
+				Add(oldKeys[slot], oldCounts[slot]);
+			}
+		}
+
+		std::vector<uint64_t> m_keys;
+		std::vector<UInt128> m_counts;
+		std::vector<uint32_t> m_usedSlots;
+		uint32_t m_mask = 0;
+		bool m_hasOverflowed = false;
+	};
 
 	virtual void ParseInput(FileStreamReader& fileReader) override
 	{
 		// Parse Input. Input never changes between parts of a problem.
 		std::string line;
-		std::vector<std::string> tokens;
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
-			StringUtil::SplitBy(line, " ", tokens);
-			for (const std::string& tok : tokens)
+			const char* cursor = line.c_str();
+			char* next = nullptr;
+			for (uint64_t value = strtoull(cursor, &next, 10); next != cursor; value = strtoull(cursor, &next, 10))
 			{
-				m_pebbles.push_back(StringUtil::AtoiU64(tok.c_str()));
+				m_pebbles.push_back(value);
+				cursor = next;
 			}
 		}
+	}
 
-		uint64_t testValues[] = { 1, 14, 32, 129, 3329, 23409, 1238902, 129384, 3490250, 98643276, 122893098, 1999992314 };
-		for (uint64_t tst : testValues)
+	// Applies the rules to one stone, calling func for each stone it turns into. False (and no calls) if the stone would
+	// be multiplied past 64 bits.
+	template<typename Func>
+	static bool BlinkStone(uint64_t value, Func&& func)
+	{
+		if (value == 0)
 		{
-			assert(Math::Log10(tst) == (uint32_t)log10l((long double)tst));
+			func(1ULL);
+			return true;
 		}
 
+		const uint32_t digits = Math::CountDigits(value);
+		if ((digits & 1) == 0)
+		{
+			const uint64_t half = Math::Pow10(digits / 2);
+			func(value / half);
+			func(value % half);
+			return true;
+		}
+
+		if (value > ~0ULL / 2024ULL)
+		{
+			return false;
+		}
+
+		func(value * 2024ULL);
+		return true;
 	}
 
-	void ResetMap(PebbleMap& dst) const
+	// False if a stone value or a count outgrew its storage.
+	static bool Step(const PebbleMap& src, PebbleMap& dst)
 	{
-		for (std::pair<const uint64_t, uint64_t>& kvp : dst)
+		bool isValid = true;
+		dst.Clear();
+		src.ForEach([&](uint64_t value, const UInt128& count)
 		{
-			kvp.second = 0;
-		}
+			isValid &= BlinkStone(value, [&](uint64_t newValue) { dst.Add(newValue, count); });
+		});
+		return isValid && !dst.HasOverflowed();
 	}
 
-	void AddEntry(uint64_t value, uint64_t count, PebbleMap& dst) const
+	// Exact, or false once a stone value outgrows 64 bits or a count outgrows 128. On real inputs the counts go first,
+	// at roughly 200 blinks.
+	bool CountAfterBlinks(uint32_t numBlinks, UInt128& outTotal) const
 	{
-		PebbleMap::iterator itFind = dst.find(value);
-		if (itFind == dst.end())
+		PebbleMap maps[2];
+		uint32_t idx = 0;
+		for (const uint64_t peb : m_pebbles)
 		{
-			dst.insert(std::make_pair(value, count));
+			maps[0].Add(peb, 1);
 		}
-		else
+
+		for (uint32_t i = 0; i < numBlinks; ++i)
 		{
-			itFind->second += count;
+			if (!Step(maps[idx], maps[idx ^ 1]))
+			{
+				return false;
+			}
+			idx ^= 1;
 		}
+
+		return maps[idx].Total(outTotal);
 	}
 
-	void Step(const PebbleMap& src, PebbleMap& dst) const
+	// Every stone value eventually lands in a closed set of values that only turn into each other, so the stone count
+	// after n blinks is 1^T M^n v for the sparse transition matrix M of that set. The matrix is thousands of values wide
+	// on real inputs, far too big to square, but the count sequence obeys a linear recurrence of order at most the number
+	// of values. Berlekamp-Massey finds it from the first 2k blinks (mod a 61 bit prime, then checked exactly against the
+	// 2^128 counts), after which any blink count is x^N mod the recurrence's characteristic polynomial, built by repeated
+	// squaring. The powers x^(2^i) are cached, so later queries only pay for the multiplies. Only worth building for
+	// blink counts far past the puzzle's, which come from the command line (see main).
+	class StoneGraph
 	{
-		char splitBuffer[32] = { 0 };
-		char left[16] = { 0 };
-		char right[16] = { 0 };
-
-		for (const std::pair<const uint64_t, uint64_t>& kvp : src)
+	public:
+		void Build(const std::vector<uint64_t>& stones)
 		{
-			if (kvp.first == 0)
+			assert(!m_isBuilt);
+			m_isBuilt = true;
+
+			std::unordered_map<uint64_t, uint32_t> valueIds;
+			auto getId = [&](uint64_t value)
 			{
-				AddEntry(1, kvp.second, dst);
+				auto it = valueIds.find(value);
+				if (it != valueIds.end())
+				{
+					return it->second;
+				}
+
+				const uint32_t id = (uint32_t)m_values.size();
+				valueIds.emplace(value, id);
+				m_values.push_back(value);
+				m_children.push_back({ INVALID_ID, INVALID_ID });
+				return id;
+			};
+
+			for (uint64_t stone : stones)
+			{
+				const uint32_t id = getId(stone);
+				m_counts.resize(m_values.size());
+				m_counts[id] += 1;
 			}
-			else if (((Math::Log10(kvp.first) + 1) & 1) == 0)
+
+			// Discover the closed set, m_values grows as new ones turn up.
+			for (uint32_t id = 0; id < (uint32_t)m_values.size(); ++id)
 			{
-				sprintf_s(splitBuffer, "%llu", kvp.first);
-				size_t len = strlen(splitBuffer) / 2;
-				memcpy(left, splitBuffer, len);
-				left[len] = '\0';
-				memcpy(right, splitBuffer + len, len);
-				right[len] = '\0';
+				uint32_t numChildren = 0;
+				const bool isValid = BlinkStone(m_values[id], [&](uint64_t newValue)
+				{
+					const uint32_t childId = getId(newValue);
+					m_children[id][numChildren++] = childId;
+				});
 
-				AddEntry(StringUtil::AtoiU64(left), kvp.second, dst);
-				AddEntry(StringUtil::AtoiU64(right), kvp.second, dst);
+				if (!isValid)
+				{
+					return;
+				}
 			}
-			else
+			m_counts.resize(m_values.size());
+
+			// The sequence's minimal polynomial divides M's, so 2k terms are enough for Berlekamp-Massey.
+			std::vector<uint64_t> countsModP(m_values.size(), 0);
+			for (size_t id = 0; id < m_counts.size(); ++id)
 			{
-				AddEntry(kvp.first * 2024ULL, kvp.second, dst);
+				countsModP[id] = m_counts[id].low % PRIME;
 			}
+
+			std::vector<uint64_t> totalsModP;
+			const size_t numTerms = 2 * m_values.size() + 2;
+			for (size_t n = 0; n < numTerms; ++n)
+			{
+				UInt128 total;
+				uint64_t totalModP = 0;
+				for (size_t id = 0; id < m_counts.size(); ++id)
+				{
+					total += m_counts[id];
+					totalModP = AddMod(totalModP, countsModP[id]);
+				}
+				m_totals.push_back(total);
+				totalsModP.push_back(totalModP);
+
+				if (n + 1 < numTerms)
+				{
+					Step(m_counts, countsModP);
+				}
+			}
+
+			FindRecurrence(totalsModP);
 		}
-	}
 
-	virtual void PartOne(const AdventGUIContext& context) override
-	{
-		// Part One
-		std::vector<uint64_t> pingPong[2];
-		PebbleMap mapPing[2];
-		uint32_t idx = 0;
-		uint32_t numSteps = 25;
+		// Some stone in the closed set would outgrow 64 bits, so Build gave up and there's nothing to query.
+		bool HasOverflowed() const { return m_isBuilt && m_totals.empty(); }
 
-		pingPong[0].insert(pingPong[0].begin(), m_pebbles.begin(), m_pebbles.end());
-		for (const uint64_t peb : m_pebbles)
+		// Counts wrap modulo 2^128.
+		UInt128 CountAfterBlinks(uint64_t numBlinks)
 		{
-			AddEntry(peb, 1, mapPing[0]);
+			if (numBlinks < m_totals.size())
+			{
+				return m_totals[(size_t)numBlinks];
+			}
+
+			if (m_recurrence.empty())
+			{
+				// No usable recurrence, keep blinking from where Build stopped.
+				std::vector<UInt128> counts = m_counts;
+				std::vector<uint64_t> unusedModP(counts.size(), 0);
+				for (uint64_t n = m_totals.size() - 1; n < numBlinks; ++n)
+				{
+					Step(counts, unusedModP);
+				}
+
+				UInt128 total;
+				for (const UInt128& count : counts)
+				{
+					total += count;
+				}
+				return total;
+			}
+
+			// x^a * x^b == x^(a + b), so the set bits can be applied in any order.
+			const size_t order = m_recurrence.size();
+			std::vector<UInt128> poly(order);
+			poly[0] = 1;
+			uint64_t remaining = numBlinks;
+			for (uint32_t bit = 0; remaining; ++bit, remaining >>= 1)
+			{
+				if (bit == m_powers.size())
+				{
+					if (m_powers.empty())
+					{
+						std::vector<UInt128> x(std::max<size_t>(order, 2));
+						x[1] = 1;
+						m_powers.push_back(Reduce(x));
+					}
+					else
+					{
+						m_powers.push_back(MultiplyMod(m_powers.back(), m_powers.back()));
+					}
+				}
+
+				if (remaining & 1)
+				{
+					poly = MultiplyMod(poly, m_powers[bit]);
+				}
+			}
+
+			UInt128 total;
+			for (size_t j = 0; j < order; ++j)
+			{
+				total += poly[j] * m_totals[j];
+			}
+			return total;
 		}
 
-		for (uint32_t i = 0; i < numSteps; ++i)
+	private:
+		enum : uint32_t { INVALID_ID = ~0U };
+		enum : uint64_t { PRIME = (1ULL << 61) - 1 };
+
+		static uint64_t AddMod(uint64_t a, uint64_t b)
 		{
-			// Map version
-			mapPing[idx ^ 1] = mapPing[idx];
-			ResetMap(mapPing[idx ^ 1]);
-			Step(mapPing[idx], mapPing[idx ^1]);
+			const uint64_t sum = a + b;
+			return sum >= PRIME ? sum - PRIME : sum;
+		}
 
-			idx ^=1;
+		static uint64_t MulMod(uint64_t a, uint64_t b)
+		{
+			const UInt128 product = UInt128::Multiply(a, b);
+			return AddMod(product.low & PRIME, (product.low >> 61) | (product.high << 3));
 		}
 
-		uint64_t mapTotal = 0;
-		for (const std::pair<uint64_t, uint64_t>& kvp : mapPing[idx])
+		static uint64_t InverseMod(uint64_t value)
 		{
-			mapTotal += kvp.second;
+			uint64_t result = 1;
+			for (uint64_t exponent = PRIME - 2; exponent; exponent >>= 1)
+			{
+				if (exponent & 1)
+				{
+					result = MulMod(result, value);
+				}
+				value = MulMod(value, value);
+			}
+			return result;
 		}
 
-		Log("Total After %u steps - %llu", numSteps, mapTotal);
+		// One blink over the sparse transition matrix, exact (mod 2^128) and mod PRIME side by side.
+		void Step(std::vector<UInt128>& counts, std::vector<uint64_t>& countsModP) const
+		{
+			std::vector<UInt128> nextCounts(counts.size());
+			std::vector<uint64_t> nextCountsModP(counts.size(), 0);
+			for (uint32_t id = 0; id < (uint32_t)m_children.size(); ++id)
+			{
+				for (uint32_t child : m_children[id])
+				{
+					if (child != INVALID_ID)
+					{
+						nextCounts[child] += counts[id];
+						nextCountsModP[child] = AddMod(nextCountsModP[child], countsModP[id]);
+					}
+				}
+			}
+			counts.swap(nextCounts);
+			countsModP.swap(nextCountsModP);
+		}
 
-		// Keep the party going...
-		uint32_t additionalSteps = 50;
-		for (uint32_t i = 0; i < additionalSteps; ++i)
+		// Berlekamp-Massey over GF(PRIME). The recurrence of an integer sequence has integer coefficients, and they're
+		// small here, so the symmetric residues are taken as the true values and then checked against every exact total.
+		void FindRecurrence(const std::vector<uint64_t>& sequence)
 		{
-			// Map version
-			mapPing[idx ^ 1] = mapPing[idx];
-			ResetMap(mapPing[idx ^ 1]);
-			Step(mapPing[idx], mapPing[idx ^ 1]);
+			std::vector<uint64_t> current(1, 1);
+			std::vector<uint64_t> previous(1, 1);
+			size_t length = 0;
+			size_t shift = 1;
+			uint64_t previousDiscrepancy = 1;
+			for (size_t n = 0; n < sequence.size(); ++n)
+			{
+				uint64_t discrepancy = sequence[n];
+				for (size_t i = 1; i <= length; ++i)
+				{
+					discrepancy = AddMod(discrepancy, MulMod(current[i], sequence[n - i]));
+				}
 
-			idx ^= 1;
+				if (discrepancy == 0)
+				{
+					++shift;
+					continue;
+				}
+
+				const std::vector<uint64_t> saved = current;
+				const uint64_t scale = PRIME - MulMod(discrepancy, InverseMod(previousDiscrepancy));
+				current.resize(std::max(current.size(), previous.size() + shift), 0);
+				for (size_t i = 0; i < previous.size(); ++i)
+				{
+					current[i + shift] = AddMod(current[i + shift], MulMod(scale, previous[i]));
+				}
+
+				if (2 * length <= n)
+				{
+					length = n + 1 - length;
+					previous = saved;
+					previousDiscrepancy = discrepancy;
+					shift = 1;
+				}
+				else
+				{
+					++shift;
+				}
+			}
+
+			// a[n] = sum r[i - 1] * a[n - i], with r[i - 1] = -current[i].
+			current.resize(length + 1, 0);
+			m_recurrence.resize(length);
+			for (size_t i = 1; i <= length; ++i)
+			{
+				const uint64_t residue = current[i] == 0 ? 0 : PRIME - current[i];
+				const int64_t value = residue > PRIME / 2 ? (int64_t)residue - (int64_t)PRIME : (int64_t)residue;
+				m_recurrence[i - 1] = UInt128((uint64_t)value, value < 0 ? ~0ULL : 0);
+			}
+
+			for (size_t n = length; n < m_totals.size(); ++n)
+			{
+				UInt128 predicted;
+				for (size_t i = 1; i <= length; ++i)
+				{
+					predicted += m_recurrence[i - 1] * m_totals[n - i];
+				}
+
+				if (predicted != m_totals[n])
+				{
+					m_recurrence.clear();
+					return;
+				}
+			}
+		}
+
+		// Folds every x^m with m >= order back down using x^order = sum r[i - 1] * x^(order - i).
+		std::vector<UInt128> Reduce(std::vector<UInt128> poly) const
+		{
+			const size_t order = m_recurrence.size();
+			for (size_t m = poly.size() - 1; m >= order; --m)
+			{
+				const UInt128 coefficient = poly[m];
+				if (!coefficient.IsZero())
+				{
+					for (size_t i = 1; i <= order; ++i)
+					{
+						poly[m - i] += coefficient * m_recurrence[i - 1];
+					}
+				}
+			}
+			poly.resize(order);
+			return poly;
 		}
 
-		mapTotal = 0;
-		for (const std::pair<uint64_t, uint64_t>& kvp : mapPing[idx])
+		std::vector<UInt128> MultiplyMod(const std::vector<UInt128>& lhs, const std::vector<UInt128>& rhs) const
 		{
-			mapTotal += kvp.second;
+			const size_t order = m_recurrence.size();
+			std::vector<UInt128> product(2 * order - 1);
+			for (size_t i = 0; i < order; ++i)
+			{
+				if (lhs[i].IsZero())
+				{
+					continue;
+				}
+
+				for (size_t j = 0; j < order; ++j)
+				{
+					product[i + j] += lhs[i] * rhs[j];
+				}
+			}
+			return Reduce(product);
 		}
 
-		Log("Total After %u steps - %llu", numSteps + additionalSteps, mapTotal);
+		std::vector<uint64_t> m_values;
+		std::vector<std::array<uint32_t, 2>> m_children; // A stone turns into one or two others.
+		std::vector<UInt128> m_counts;                   // Per value counts after the last blink Build simulated.
+		std::vector<UInt128> m_totals;                   // m_totals[n] = stones after n blinks.
+		std::vector<UInt128> m_recurrence;               // Empty if no recurrence was found.
+		std::vector<std::vector<UInt128>> m_powers;      // m_powers[i] = x^(2^i) mod the characteristic polynomial.
+		bool m_isBuilt = false;
+	};
+
+	virtual void PartOne(const AdventGUIContext& context) override
+	{
+		// Part One
+		uint32_t numSteps = 25;
+		LogStoneCount(numSteps);
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
@@ -147,15 +518,66 @@ private:
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
+		uint32_t numSteps = 75;
+		LogStoneCount(numSteps);
+
+		if (!m_graphQueries.empty())
+		{
+			RunGraphQueries();
+		}
 
 		// Done.
 		AdventGUIInstance::PartTwo(context);
 	}
 
+	void LogStoneCount(uint32_t numSteps)
+	{
+		UInt128 total;
+		if (!CountAfterBlinks(numSteps, total))
+		{
+			Log("Error: stones outgrew 64 bit values or 128 bit counts within %u steps", numSteps);
+			return;
+		}
+
+		char totalBuffer[48];
+		Log("Total After %u steps - %s", numSteps, total.ToString(totalBuffer, sizeof(totalBuffer)));
+	}
+
+	// Answers every requested blink count from one graph, modulo 2^128. Wherever the direct simulation is still exact it
+	// runs too, and the two have to agree.
+	void RunGraphQueries()
+	{
+		m_stoneGraph.Build(m_pebbles);
+		if (m_stoneGraph.HasOverflowed())
+		{
+			Log("Error: stone values outgrew 64 bits, no graph to query");
+			return;
+		}
+
+		for (uint64_t numBlinks : m_graphQueries)
+		{
+			char totalBuffer[48];
+			const UInt128 total = m_stoneGraph.CountAfterBlinks(numBlinks);
+			Log("Total After %llu steps (mod 2^128) - %s", numBlinks, total.ToString(totalBuffer, sizeof(totalBuffer)));
+
+			UInt128 expected;
+			if (numBlinks <= VERIFY_MAX_BLINKS && CountAfterBlinks((uint32_t)numBlinks, expected) && expected != total)
+			{
+				Log("Error: graph disagrees with direct simulation (%s) after %llu steps", expected.ToString(totalBuffer, sizeof(totalBuffer)), numBlinks);
+			}
+		}
+	}
+
+	// Exact counts run out after a couple of hundred blinks anyway, this only stops runaway simulation of tiny inputs.
+	enum : uint64_t { VERIFY_MAX_BLINKS = 1000 };
+
 	std::vector<uint64_t> m_pebbles;
+	std::vector<uint64_t> m_graphQueries; // Extra blink counts to answer with the graph, from the command line.
+	StoneGraph m_stoneGraph;
 };
 
-int main()
+// Any arguments are extra blink counts, answered from the stone graph after Part Two, e.g. "Day11 1000000 1000001".
+int main(int argc, char* argv[])
 {
 	AdventGUIParams newParams;
 	newParams.day = 11;
@@ -163,7 +585,13 @@ int main()
 	newParams.puzzleTitle = "Plutonian Pebbles";
 	newParams.inputFilename = "input.txt";
 
-	AdventGUIInstance::InstantiateAndExecute<AdventDay>(newParams);
+	std::vector<uint64_t> graphQueries;
+	for (int i = 1; i < argc; ++i)
+	{
+		graphQueries.push_back(strtoull(argv[i], nullptr, 10));
+	}
+
+	AdventGUIInstance::InstantiateAndExecute<AdventDay>(newParams, std::move(graphQueries));
 
 	return 0;
 }
@@ -1,22 +1,5 @@
 #include "AdventGUI/AdventGUI.h"
-#include "ACUtils/Algorithm.h"
-#include "ACUtils/Enum.h"
-#include "ACUtils/IntVec.h"
-#include <queue>
-
-enum class Edges : uint8_t
-{
-	None = 0,
-	Top = 1 << 0,
-	Left = 1 << 1,
-	Bottom = 1 << 2,
-	Right = 1 << 3,
-	TopLeft = Top | Left,
-	TopRight = Top | Right,
-	BottomLeft = Bottom | Left,
-	BottomRight = Bottom | Right,
-};
-DECLARE_ENUM_BITFIELD_OPERATORS(Edges);
+#include "ACUtils/Parallel.h"
 
 class AdventDay : public AdventGUIInstance
 {
@@ -32,6 +15,11 @@ private:
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
+			if (line.empty())
+			{
+				continue;
+			}
+
 			if (m_mapWidth == 0)
 			{
 				m_mapWidth = line.size();
@@ -40,182 +28,165 @@ private:
 			m_map.append(line);
 		}
 
-		m_mapHeight = m_map.size() / m_mapWidth;
+		m_mapHeight = m_mapWidth ? m_map.size() / m_mapWidth : 0;
+
+		LabelRegions();
 	}
 
-	char GetData(int x, int y) const
+	// True if (x + dx, y + dy) is on the map and holds the same plant as (x, y).
+	bool IsSame(size_t x, size_t y, int dx, int dy) const
 	{
-		if (x < 0 || x >= m_mapWidth || y < 0 || y >= m_mapHeight)
+		const size_t nx = x + dx;
+		const size_t ny = y + dy;
+		if (nx >= m_mapWidth || ny >= m_mapHeight)
 		{
-			return '\0';
+			return false;
 		}
 
-		return m_map[y * m_mapWidth + x];
+		return m_map[ny * m_mapWidth + nx] == m_map[y * m_mapWidth + x];
 	}
 
-	char GetData(const IntVec2& xy) const
+	// Roots are always the lowest cell index in their set, which keeps labels stable and lets the final pass resolve
+	// every cell in one forward sweep.
+	uint32_t Find(uint32_t cell)
 	{
-		return GetData(xy.x, xy.y);
+		while (m_parent[cell] != cell)
+		{
+			m_parent[cell] = m_parent[m_parent[cell]];
+			cell = m_parent[cell];
+		}
+		return cell;
 	}
 
-#define LOOKUP(x, y) (y * m_mapWidth + x)
-
-	void price(IntVec2 pos, uint32_t& outArea, uint32_t& outPerimeter, uint32_t& outNumSides, std::vector<bool>& outSeen, std::vector<Edges>& edges)
+	// Joins the sets holding a and b, folding the statistics gathered so far into the surviving root.
+	void Union(uint32_t a, uint32_t b)
 	{
-		std::queue<IntVec2> scanQueue;
-		scanQueue.emplace(pos);
-		IntVec2 curr;
-		char c;
-		outPerimeter = 0;
-		outArea = 0;
-		outNumSides = 0;
-
-		int i, j = 0;
-
-		do {
-			curr = scanQueue.front();
-			scanQueue.pop();
-			i = curr.x;
-			j = curr.y;
-
-			if (outSeen[LOOKUP(i, j)])
-			{
-				continue;
-			}
+		uint32_t rootA = Find(a);
+		uint32_t rootB = Find(b);
+		if (rootA == rootB)
+		{
+			return;
+		}
 
-			outSeen[LOOKUP(i, j)] = true;
-			const char plant = GetData(pos);
-
-			++outArea; 
-			if (GetData(i - 1,j) == plant) { edges[LOOKUP(i,j)] |= Edges::Top; scanQueue.emplace(i - 1, j); }
-			else ++outPerimeter;
-			if (GetData(i + 1, j) == plant) { edges[LOOKUP(i, j)] |= Edges::Bottom; scanQueue.emplace(i + 1, j); }
-			else ++outPerimeter;
-			if (GetData(i, j - 1) == plant) { edges[LOOKUP(i, j)] |= Edges::Left; scanQueue.emplace(i, j - 1); }
-			else ++outPerimeter;
-			if (GetData(i, j + 1) == plant) { edges[LOOKUP(i, j)] |= Edges::Right; scanQueue.emplace(i, j + 1); }
-			else ++outPerimeter;
-			// Part 2
-			switch (edges[LOOKUP(i,j)] & Edges::TopLeft) {
-			case Edges::None: ++outNumSides; break;
-			case Edges::TopLeft: outNumSides += GetData(i - 1, j - 1) != plant; break;
-			}
-			switch (edges[LOOKUP(i, j)] & Edges::BottomLeft) {
-			case Edges::None: ++outNumSides; break;
-			case Edges::BottomLeft: outNumSides += GetData(i + 1,j - 1) != plant; break;
-			}
-			switch (edges[LOOKUP(i, j)] & Edges::TopRight) {
-			case Edges::None: ++outNumSides; break;
-			case Edges::TopRight: outNumSides += GetData(i - 1, j + 1) != plant; break;
-			}
-			switch (edges[LOOKUP(i, j)] & Edges::BottomRight) {
-			case Edges::None: ++outNumSides; break;
-			case Edges::BottomRight: outNumSides += GetData(i + 1,j + 1) != plant; break;
-			}
-		} while (!scanQueue.empty());
+		if (rootA < rootB)
+		{
+			std::swap(rootA, rootB);
+		}
+
+		m_parent[rootA] = rootB;
+		m_area[rootB] += m_area[rootA];
+		m_perimeter[rootB] += m_perimeter[rootA];
+		m_sides[rootB] += m_sides[rootA];
 	}
 
-	void Fill(IntVec2 pos, uint32_t& outArea, uint32_t& outPerimeter, uint32_t& outNumSides, std::vector<bool>& outSeen, std::vector<Edges>& edges) const
+	// Fences and corners a cell contributes. A region has as many sides as corners: a convex corner where both
+	// neighbours towards a diagonal are foreign, a concave one where both match but the diagonal itself doesn't.
+	void AddCellStats(size_t x, size_t y, uint32_t root)
 	{
-		std::queue<IntVec2> scanQueue;
-		scanQueue.emplace(pos);
-		IntVec2 curr;
-		char c;
-		outPerimeter = 0;
-		outArea = 0;
-		outNumSides = 0;
-
-		const IntVec2 offsets[] = {{-1, 0}, {0, 1}, {1, 0}, {0, -1}};
-		const Edges offEdge[] = { Edges::Top, Edges::Right, Edges::Bottom, Edges::Left };
-		const IntVec2 diagOffsets[] = { {-1, -1}, {-1, 1}, {1, -1}, {1, 1} };
-		const Edges diagEdge[]= { Edges::TopLeft, Edges::TopRight, Edges::BottomLeft, Edges::BottomRight };
-		IntVec2 next;
-		while (!scanQueue.empty())
-		{
-			curr = scanQueue.front();
-			scanQueue.pop();
+		static const int diagonals[4][2] = { { -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 } };
 
-			size_t i = curr.y * m_mapWidth + curr.x;
-			c = m_map[i];
+		uint32_t fences = 0;
+		fences += IsSame(x, y, -1, 0) ? 0 : 1;
+		fences += IsSame(x, y, 1, 0) ? 0 : 1;
+		fences += IsSame(x, y, 0, -1) ? 0 : 1;
+		fences += IsSame(x, y, 0, 1) ? 0 : 1;
 
-			if (outSeen[i])
+		uint32_t corners = 0;
+		for (const int* diag : diagonals)
+		{
+			const bool horizontal = IsSame(x, y, diag[0], 0);
+			const bool vertical = IsSame(x, y, 0, diag[1]);
+			if (horizontal == vertical && (!horizontal || !IsSame(x, y, diag[0], diag[1])))
 			{
-				continue;
+				++corners;
 			}
+		}
+
+		m_area[root] += 1;
+		m_perimeter[root] += fences;
+		m_sides[root] += corners;
+	}
 
-			outSeen[i] = true;
-			++outArea;
-			for(size_t j = 0; j < 4; ++j)
+	// Two pass connected component labelling. Horizontal stripes are labelled in parallel (every union stays inside the
+	// stripe, so the union-find entries a thread touches are its own) and accumulate their statistics on the stripe
+	// local roots. The stripe seams are then unioned serially, merging statistics as sets join, and a final sweep
+	// collects one entry per region.
+	void LabelRegions()
+	{
+		const size_t numCells = m_map.size();
+		m_parent.resize(numCells);
+		m_area.assign(numCells, 0);
+		m_perimeter.assign(numCells, 0);
+		m_sides.assign(numCells, 0);
+
+		const size_t stripeRows = std::max<size_t>(16, (m_mapHeight + Parallel::GetNumThreads() * 4 - 1) / (Parallel::GetNumThreads() * 4));
+		Parallel::For(m_mapHeight, stripeRows, [&](uint32_t, size_t rowBegin, size_t rowEnd)
+		{
+			for (size_t y = rowBegin; y < rowEnd; ++y)
 			{
-				const IntVec2& off = offsets[j];
-				next = curr + off;
-				if (GetData(next) == c)
-				{
-					scanQueue.push(curr + off);
-				}
-				else
+				for (size_t x = 0; x < m_mapWidth; ++x)
 				{
-					edges[i] |= offEdge[j];
-					++outPerimeter;
+					const uint32_t cell = (uint32_t)(y * m_mapWidth + x);
+					m_parent[cell] = cell;
+					if (IsSame(x, y, -1, 0))
+					{
+						Union(cell - 1, cell);
+					}
+					if (y > rowBegin && IsSame(x, y, 0, -1))
+					{
+						Union((uint32_t)(cell - m_mapWidth), cell);
+					}
 				}
 			}
 
-
-			if ((edges[i] & Edges::TopLeft) == Edges::TopLeft)
-			{
-				++outNumSides;
-			}
-
-			if ((edges[i] & Edges::TopRight) == Edges::TopRight)
+			for (size_t y = rowBegin; y < rowEnd; ++y)
 			{
-				++outNumSides;
+				for (size_t x = 0; x < m_mapWidth; ++x)
+				{
+					AddCellStats(x, y, Find((uint32_t)(y * m_mapWidth + x)));
+				}
 			}
+		});
 
-			if ((edges[i] & Edges::BottomLeft) == Edges::BottomLeft)
+		// Parallel::For chunks are fixed size, so the seams sit on multiples of stripeRows.
+		for (size_t y = stripeRows; y < m_mapHeight; y += stripeRows)
+		{
+			for (size_t x = 0; x < m_mapWidth; ++x)
 			{
-				++outNumSides;
+				if (IsSame(x, y, 0, -1))
+				{
+					const uint32_t cell = (uint32_t)(y * m_mapWidth + x);
+					Union((uint32_t)(cell - m_mapWidth), cell);
+				}
 			}
+		}
 
-			if ((edges[i] & Edges::BottomRight) == Edges::BottomRight)
+		m_regionPlant.clear();
+		m_regionArea.clear();
+		m_regionPerimeter.clear();
+		m_regionSides.clear();
+		for (uint32_t cell = 0; cell < (uint32_t)numCells; ++cell)
+		{
+			if (Find(cell) == cell)
 			{
-				++outNumSides;
+				m_regionPlant.push_back(m_map[cell]);
+				m_regionArea.push_back(m_area[cell]);
+				m_regionPerimeter.push_back(m_perimeter[cell]);
+				m_regionSides.push_back(m_sides[cell]);
 			}
-					
 		}
 	}
 
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
-		std::vector<bool> seenLocs;
-		seenLocs.reserve(m_map.size());
-		seenLocs.insert(seenLocs.begin(), m_map.size(), false);
-		
-		std::vector<Edges> edgeInfo;
-		edgeInfo.reserve(m_map.size());
-		edgeInfo.insert(edgeInfo.begin(), m_map.size(), Edges::None);
-
-
 		uint64_t sum = 0;
-		uint64_t sumTwo = 0;
-		uint32_t area = 0;
-		uint32_t perimeter = 0;
-		uint32_t sides = 0;
-
-		for (size_t i = 0; i < m_map.size(); ++i)
+		for (size_t i = 0; i < m_regionArea.size(); ++i)
 		{
-			if (!seenLocs[i])
-			{
-				price(IntVec2((int)(i % m_mapWidth), (int)(i / m_mapWidth)), area, perimeter, sides, seenLocs, edgeInfo);
-				assert(seenLocs[i]);
-
-				Log("Found Plot [%c] Area [%u] Sides [%u] = %u", m_map[i], area, perimeter, area * perimeter);
-				sum += area * perimeter;
-				sumTwo += area * sides;
-			}
+			sum += (uint64_t)m_regionArea[i] * m_regionPerimeter[i];
 		}
 
-		Log("Total = %llu", sum);
+		Log("Total = %llu (%zd regions)", sum, m_regionArea.size());
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
@@ -224,6 +195,13 @@ private:
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
+		uint64_t sum = 0;
+		for (size_t i = 0; i < m_regionArea.size(); ++i)
+		{
+			sum += (uint64_t)m_regionArea[i] * m_regionSides[i];
+		}
+
+		Log("Total = %llu", sum);
 
 		// Done.
 		AdventGUIInstance::PartTwo(context);
@@ -232,6 +210,18 @@ private:
 	std::string m_map;
 	size_t m_mapWidth;
 	size_t m_mapHeight;
+
+	// Union-find scratch, indexed by cell. Statistics are only meaningful on roots.
+	std::vector<uint32_t> m_parent;
+	std::vector<uint32_t> m_area;
+	std::vector<uint32_t> m_perimeter;
+	std::vector<uint32_t> m_sides;
+
+	// Per region results, in order of each region's first cell.
+	std::vector<char> m_regionPlant;
+	std::vector<uint32_t> m_regionArea;
+	std::vector<uint32_t> m_regionPerimeter;
+	std::vector<uint32_t> m_regionSides;
 };
 
 int main()
@@ -1,7 +1,6 @@
 #include "AdventGUI/AdventGUI.h"
-#include "ACUtils/Algorithm.h"
-#include "ACUtils/IntVec.h"
-
+#include "ACUtils/Int128.h"
+#include <intrin.h>
 
 class AdventDay : public AdventGUIInstance
 {
@@ -9,118 +8,321 @@ public:
 	AdventDay(const AdventGUIParams& params) : AdventGUIInstance(params) {};
 
 private:
-	struct ClawContext
+	virtual void ParseInput(FileStreamReader& fileReader) override
 	{
-		Int64Vec2 BtnA;
-		Int64Vec2 BtnB;
-		Int64Vec2 Target;
+		// Parse Input. Input never changes between parts of a problem.
+		std::string line;
+		std::vector<std::string> tokens;
+		int64_t* fields[3][2] = { { nullptr } };
+		while (!fileReader.IsEOF())
+		{
+			line = fileReader.ReadLine();
+			if (line.empty())
+			{
+				continue;
+			}
+
+			m_machines.Resize(m_machines.Size() + 1);
+			const size_t idx = m_machines.Size() - 1;
+			fields[0][0] = &m_machines.btnAX[idx];
+			fields[0][1] = &m_machines.btnAY[idx];
+			fields[1][0] = &m_machines.btnBX[idx];
+			fields[1][1] = &m_machines.btnBY[idx];
+			fields[2][0] = &m_machines.targetX[idx];
+			fields[2][1] = &m_machines.targetY[idx];
+
+			// Button A, Button B then Prize.
+			for (int row = 0; row < 3; ++row)
+			{
+				if (row > 0)
+				{
+					line = fileReader.ReadLine();
+				}
+
+				StringUtil::SplitBy(line, ":|,", tokens);
+				assert(tokens.size() == 3);
+				*fields[row][0] = StringUtil::AtoiI64(tokens[1].substr(2).c_str());
+				*fields[row][1] = StringUtil::AtoiI64(tokens[2].substr(2).c_str());
+			}
+		}
+	}
+
+	// Structure of arrays so the solver can pull a lane per machine straight out of each field.
+	struct MachineArrays
+	{
+		std::vector<int64_t> btnAX;
+		std::vector<int64_t> btnAY;
+		std::vector<int64_t> btnBX;
+		std::vector<int64_t> btnBY;
+		std::vector<int64_t> targetX;
+		std::vector<int64_t> targetY;
+
+		size_t Size() const { return btnAX.size(); }
+
+		void Resize(size_t count)
+		{
+			btnAX.resize(count);
+			btnAY.resize(count);
+			btnBX.resize(count);
+			btnBY.resize(count);
+			targetX.resize(count);
+			targetY.resize(count);
+		}
 	};
 
-	uint64_t Score(const ClawContext& context, bool partTwo = false) const
+	static constexpr uint64_t A_COST = 3;
+	static constexpr uint64_t B_COST = 1;
+
+	static uint32_t BitsNeeded(int64_t value)
+	{
+		const uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+		return magnitude ? 64 - (uint32_t)__lzcnt64(magnitude) : 0;
+	}
+
+	// Doubles hold every integer below 2^53 exactly. With both cross products below 2^51 the determinants, numerators
+	// and the quotient check below can't round.
+	bool FitsDoubleLane(size_t idx, int64_t offset) const
+	{
+		const MachineArrays& m = m_machines;
+		uint32_t buttonBits = std::max(std::max(BitsNeeded(m.btnAX[idx]), BitsNeeded(m.btnAY[idx])), std::max(BitsNeeded(m.btnBX[idx]), BitsNeeded(m.btnBY[idx])));
+		uint32_t targetBits = std::max(BitsNeeded(m.targetX[idx] + offset), BitsNeeded(m.targetY[idx] + offset));
+		return buttonBits + std::max(buttonBits, targetBits) <= 51;
+	}
+
+	// Cramer's rule for two machines at once. Returns a 2 bit mask of lanes with a unique non negative integer solution,
+	// their costs in outCosts. Lanes with a zero determinant come back in outDegenerate for the scalar path.
+	uint32_t SolvePair(size_t idx, int64_t offset, uint64_t outCosts[2], uint32_t& outDegenerate) const
+	{
+		const MachineArrays& m = m_machines;
+		const __m128d ax = _mm_set_pd((double)m.btnAX[idx + 1], (double)m.btnAX[idx]);
+		const __m128d ay = _mm_set_pd((double)m.btnAY[idx + 1], (double)m.btnAY[idx]);
+		const __m128d bx = _mm_set_pd((double)m.btnBX[idx + 1], (double)m.btnBX[idx]);
+		const __m128d by = _mm_set_pd((double)m.btnBY[idx + 1], (double)m.btnBY[idx]);
+		const __m128d tx = _mm_set_pd((double)(m.targetX[idx + 1] + offset), (double)(m.targetX[idx] + offset));
+		const __m128d ty = _mm_set_pd((double)(m.targetY[idx + 1] + offset), (double)(m.targetY[idx] + offset));
+		const __m128d zero = _mm_setzero_pd();
+
+		const __m128d det = _mm_sub_pd(_mm_mul_pd(ax, by), _mm_mul_pd(ay, bx));
+		const __m128d numA = _mm_sub_pd(_mm_mul_pd(tx, by), _mm_mul_pd(ty, bx));
+		const __m128d numB = _mm_sub_pd(_mm_mul_pd(ax, ty), _mm_mul_pd(ay, tx));
+
+		const __m128d degenerate = _mm_cmpeq_pd(det, zero);
+		const __m128d safeDet = _mm_blendv_pd(det, _mm_set1_pd(1.0), degenerate);
+		const __m128d a = _mm_round_pd(_mm_div_pd(numA, safeDet), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		const __m128d b = _mm_round_pd(_mm_div_pd(numB, safeDet), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+		__m128d valid = _mm_and_pd(_mm_cmpeq_pd(_mm_mul_pd(a, safeDet), numA), _mm_cmpeq_pd(_mm_mul_pd(b, safeDet), numB));
+		valid = _mm_and_pd(valid, _mm_and_pd(_mm_cmpge_pd(a, zero), _mm_cmpge_pd(b, zero)));
+		valid = _mm_andnot_pd(degenerate, valid);
+
+		const __m128d cost = _mm_add_pd(_mm_mul_pd(a, _mm_set1_pd((double)A_COST)), _mm_mul_pd(b, _mm_set1_pd((double)B_COST)));
+		alignas(16) double costs[2];
+		_mm_store_pd(costs, cost);
+		outCosts[0] = (uint64_t)costs[0];
+		outCosts[1] = (uint64_t)costs[1];
+		outDegenerate = (uint32_t)_mm_movemask_pd(degenerate);
+		return (uint32_t)_mm_movemask_pd(valid);
+	}
+
+	// Exact path for any machine. Products are formed in 128 bits, so int64 inputs can't overflow.
+	bool Solve(size_t idx, int64_t offset, UInt128& outCost) const
 	{
-		/*
-		Button A: X+94, Y+34
-		Button B: X+22, Y+67
-		Prize: X=8400, Y=5400
-
-		8400 = 80 * 94 + 40 * 22
-		5400 = 80 * 34 + 40 * 67
-		*/
-
-		// Tx = A * Ax + B * Bx 
-		// Ty = A * Ay + B * By
-
-		// Solve for A
-		// Tx * By = A * Ax * By + B * Bx * By
-		// Ty * Bx = A * Ay * Bx + B * By * Bx
-		// 
-		// Tx * By - Ty * Bx = A * Ax * By + B * Bx * By - A * Ay * Bx + B * By * Bx
-		// 
-		// Tx * By - Ty * Bx = A * (Ay * Bx - Ax * By) // This step took FOREVER to figure out
-		// 
-		// A = (Tx * By - Ty * Bx) / (Ay * Bx - Ax * By);
-		// 
-		// Solve for B (We plug in the A above)
-		// Tx = A * Ax + B * Bx
-		// B = (Tx - A * Ax) / Bx
-		const Int64Vec2& aXY = context.BtnA;
-		const Int64Vec2& bXY = context.BtnB;
-		Int64Vec2 tXY = context.Target;
-
-		if (partTwo)
+		const MachineArrays& m = m_machines;
+		const UInt128 ax = UInt128::FromSigned(m.btnAX[idx]);
+		const UInt128 ay = UInt128::FromSigned(m.btnAY[idx]);
+		const UInt128 bx = UInt128::FromSigned(m.btnBX[idx]);
+		const UInt128 by = UInt128::FromSigned(m.btnBY[idx]);
+		const UInt128 tx = UInt128::FromSigned(m.targetX[idx]) + UInt128::FromSigned(offset);
+		const UInt128 ty = UInt128::FromSigned(m.targetY[idx]) + UInt128::FromSigned(offset);
+
+		UInt128 det = ax * by - ay * bx;
+		if (det.IsZero())
 		{
-			tXY += 10000000000000LL;
+			return SolveCollinear(idx, offset, outCost);
 		}
 
-		int64_t Adet = (aXY.y * bXY.x - aXY.x * bXY.y);
-		int64_t Anom = (bXY.x * tXY.y - bXY.y * tXY.x);
-		if ((Anom % Adet) != 0)
+		UInt128 numA = tx * by - ty * bx;
+		UInt128 numB = ax * ty - ay * tx;
+		if (det.IsNegative())
 		{
-			return -1;
+			det = det.Negated();
+			numA = numA.Negated();
+			numB = numB.Negated();
 		}
 
-		int64_t A = Anom / Adet;
+		if (numA.IsNegative() || numB.IsNegative())
+		{
+			return false;
+		}
 
-		int64_t Bdet = bXY.x;
-		int64_t Bnom = tXY.x - A * aXY.x;
-		if ((Bnom % Bdet) != 0)
+		UInt128 remainderA;
+		UInt128 remainderB;
+		const UInt128 a = UInt128::DivMod(numA, det, &remainderA);
+		const UInt128 b = UInt128::DivMod(numB, det, &remainderB);
+		if (!remainderA.IsZero() || !remainderB.IsZero())
 		{
-			return -1;
+			return false;
 		}
-		int64_t B = Bnom / Bdet;
 
-		return A * 3LL + B;
+		outCost = a * A_COST + b * B_COST;
+		return true;
 	}
 
-	virtual void ParseInput(FileStreamReader& fileReader) override
+	// Both buttons move along the same line, so there may be many ways to reach the prize. Reduced to one axis this is
+	// a * p + b * q = t, whose solutions step a by q / g and b by p / g. Cost changes linearly along that family, so the
+	// cheapest is at one end: as many presses as possible of whichever button covers distance more cheaply. Buttons are
+	// assumed to only move forward, as they do in every puzzle input.
+	bool SolveCollinear(size_t idx, int64_t offset, UInt128& outCost) const
 	{
-		// Parse Input. Input never changes between parts of a problem.
-		std::string line;
-		std::vector<std::string> tokens;
-		while (!fileReader.IsEOF())
+		const MachineArrays& m = m_machines;
+		const int64_t tx = m.targetX[idx] + offset;
+		const int64_t ty = m.targetY[idx] + offset;
+
+		// The prize has to sit on the buttons' line too.
+		const UInt128 crossA = UInt128::FromSigned(m.btnAX[idx]) * UInt128::FromSigned(ty) - UInt128::FromSigned(m.btnAY[idx]) * UInt128::FromSigned(tx);
+		const UInt128 crossB = UInt128::FromSigned(m.btnBX[idx]) * UInt128::FromSigned(ty) - UInt128::FromSigned(m.btnBY[idx]) * UInt128::FromSigned(tx);
+		if (!crossA.IsZero() || !crossB.IsZero())
 		{
-			line = fileReader.ReadLine();
-			if (line.empty())
+			return false;
+		}
+
+		const bool useX = m.btnAX[idx] != 0 || m.btnBX[idx] != 0;
+		const int64_t p = useX ? m.btnAX[idx] : m.btnAY[idx];
+		const int64_t q = useX ? m.btnBX[idx] : m.btnBY[idx];
+		const int64_t t = useX ? tx : ty;
+		if (p < 0 || q < 0 || t < 0)
+		{
+			return false;
+		}
+
+		if (p == 0 || q == 0)
+		{
+			const int64_t step = p ? p : q;
+			if (step == 0)
 			{
-				continue;
+				outCost = 0;
+				return (useX ? ty : tx) == 0 && t == 0;
 			}
 
-			StringUtil::SplitBy(line, ":|,", tokens);
-			assert(tokens.size() == 3);
-			ClawContext newClaw;
-			newClaw.BtnA.x = StringUtil::AtoiI64(tokens[1].substr(2).c_str());
-			newClaw.BtnA.y = StringUtil::AtoiI64(tokens[2].substr(2).c_str());
-			line = fileReader.ReadLine();
-			StringUtil::SplitBy(line, ":|,", tokens);
-			assert(tokens.size() == 3);
-			newClaw.BtnB.x = StringUtil::AtoiI64(tokens[1].substr(2).c_str());
-			newClaw.BtnB.y = StringUtil::AtoiI64(tokens[2].substr(2).c_str());
-			line = fileReader.ReadLine();
-			StringUtil::SplitBy(line, ":|,", tokens);
-			assert(tokens.size() == 3);
-			newClaw.Target.x = StringUtil::AtoiI64(tokens[1].substr(2).c_str());
-			newClaw.Target.y = StringUtil::AtoiI64(tokens[2].substr(2).c_str());
+			if (t % step != 0)
+			{
+				return false;
+			}
 
-			m_claws.push_back(newClaw);
+			outCost = UInt128::Multiply((uint64_t)(t / step), p ? A_COST : B_COST);
+			return true;
 		}
 
+		int64_t inverse = 0;
+		const int64_t g = ExtendedGcd(p, q, inverse);
+		if (t % g != 0)
+		{
+			return false;
+		}
+
+		const uint64_t pg = (uint64_t)(p / g);
+		const uint64_t qg = (uint64_t)(q / g);
+		const uint64_t tg = (uint64_t)(t / g);
+
+		// Fewest A presses: a = t * p^-1 mod q (all divided through by g).
+		UInt128 remainder;
+		const uint64_t inverseModQ = (uint64_t)(((inverse % (int64_t)qg) + (int64_t)qg) % (int64_t)qg);
+		UInt128::DivMod(UInt128::Multiply(tg % qg, inverseModQ), qg, &remainder);
+		UInt128 a = remainder;
+		const UInt128 distanceA = a * pg;
+		if (UInt128(tg) < distanceA)
+		{
+			return false;
+		}
+
+		// Switch to the most A presses when A covers more distance per token.
+		if (UInt128::Multiply(qg, A_COST) < UInt128::Multiply(pg, B_COST))
+		{
+			const UInt128 extraSteps = UInt128::DivMod(UInt128(tg) - distanceA, UInt128::Multiply(pg, qg));
+			a += extraSteps * qg;
+		}
+
+		const UInt128 b = UInt128::DivMod(UInt128(tg) - a * pg, qg);
+		outCost = a * A_COST + b * B_COST;
+		return true;
 	}
 
-	virtual void PartOne(const AdventGUIContext& context) override
+	// Returns gcd(a, b) and x with a * x = gcd (mod b).
+	static int64_t ExtendedGcd(int64_t a, int64_t b, int64_t& outX)
 	{
-		// Part One
-		int64_t totalSum = 0;
-		int64_t clawSum = 0;
-		for (const ClawContext& claw : m_claws)
+		int64_t oldR = a, r = b;
+		int64_t oldX = 1, x = 0;
+		while (r != 0)
 		{
-			clawSum = Score(claw);
-			if (clawSum != -1LL)
+			const int64_t quotient = oldR / r;
+			int64_t temp = oldR - quotient * r;
+			oldR = r;
+			r = temp;
+			temp = oldX - quotient * x;
+			oldX = x;
+			x = temp;
+		}
+		outX = oldX;
+		return oldR;
+	}
+
+	UInt128 TotalCost(int64_t offset, uint32_t& outNumWon) const
+	{
+		UInt128 total;
+		outNumWon = 0;
+		const size_t numMachines = m_machines.Size();
+		size_t idx = 0;
+		for (; idx + 2 <= numMachines; idx += 2)
+		{
+			if (FitsDoubleLane(idx, offset) && FitsDoubleLane(idx + 1, offset))
+			{
+				uint64_t costs[2];
+				uint32_t degenerate = 0;
+				const uint32_t valid = SolvePair(idx, offset, costs, degenerate);
+				for (uint32_t lane = 0; lane < 2; ++lane)
+				{
+					UInt128 cost = costs[lane];
+					if ((valid & (1 << lane)) || ((degenerate & (1 << lane)) && SolveCollinear(idx + lane, offset, cost)))
+					{
+						total += cost;
+						++outNumWon;
+					}
+				}
+				continue;
+			}
+
+			for (size_t lane = idx; lane < idx + 2; ++lane)
+			{
+				UInt128 cost;
+				if (Solve(lane, offset, cost))
+				{
+					total += cost;
+					++outNumWon;
+				}
+			}
+		}
+
+		for (; idx < numMachines; ++idx)
+		{
+			UInt128 cost;
+			if (Solve(idx, offset, cost))
 			{
-				totalSum += clawSum;
+				total += cost;
+				++outNumWon;
 			}
 		}
 
-		Log("Total Tokens: %lld", totalSum);
+		return total;
+	}
+
+	virtual void PartOne(const AdventGUIContext& context) override
+	{
+		// Part One
+		uint32_t numWon = 0;
+		char totalBuffer[48];
+		TotalCost(0, numWon).ToString(totalBuffer, sizeof(totalBuffer));
+
+		Log("Total Tokens: %s (%u prizes)", totalBuffer, numWon);
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
@@ -129,24 +331,17 @@ private:
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
-		int64_t totalSum = 0;
-		int64_t clawSum = 0;
-		for (const ClawContext& claw : m_claws)
-		{
-			clawSum = Score(claw, true);
-			if (clawSum != -1LL)
-			{
-				totalSum += clawSum;
-			}
-		}
+		uint32_t numWon = 0;
+		char totalBuffer[48];
+		TotalCost(10000000000000LL, numWon).ToString(totalBuffer, sizeof(totalBuffer));
 
-		Log("Total Tokens: %lld", totalSum);
+		Log("Total Tokens: %s (%u prizes)", totalBuffer, numWon);
 
 		// Done.
 		AdventGUIInstance::PartTwo(context);
 	}
 
-	std::vector<ClawContext> m_claws;
+	MachineArrays m_machines;
 };
 
 int main()
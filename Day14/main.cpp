@@ -1,170 +1,334 @@
 #include "AdventGUI/AdventGUI.h"
-#include "ACUtils/Algorithm.h"
-#include "ACUtils/IntVec.h"
+#include "ACUtils/Bit.h"
+#include "ACUtils/Int128.h"
+#include "ACUtils/Parallel.h"
+#include <intrin.h>
+#include <limits>
 
 
 class AdventDay : public AdventGUIInstance
 {
 public:
-	AdventDay(const AdventGUIParams& params) : AdventGUIInstance(params) {};
+	AdventDay(const AdventGUIParams& params, int32_t boardWidth, int32_t boardHeight)
+		: AdventGUIInstance(params), m_boardWidth(boardWidth), m_boardHeight(boardHeight) {};
 
 private:
-	struct Robot
+	// Structure of arrays robot store. Velocities are kept reduced to [0, board size) so every position update is an add
+	// and a conditional subtract.
+	struct RobotArrays
 	{
-		IntVec2 pos;
-		IntVec2 vel;
+		std::vector<int32_t> posX;
+		std::vector<int32_t> posY;
+		std::vector<int32_t> velX;
+		std::vector<int32_t> velY;
+
+		size_t Size() const { return posX.size(); }
+	};
+
+	// Where the robots are after some number of steps.
+	struct BoardSnapshot
+	{
+		uint32_t quadrants[4] = { 0, 0, 0, 0 }; // Top left, top right, bottom left, bottom right.
+		uint32_t rowWords = 0;
+		std::vector<uint64_t> occupancy;         // One bit per cell, rowWords per row.
+
+		bool IsOccupied(int32_t x, int32_t y) const
+		{
+			return (occupancy[(size_t)y * rowWords + (x >> 6)] >> (x & 63)) & 1;
+		}
 	};
 
 	virtual void ParseInput(FileStreamReader& fileReader) override
 	{
 		// Parse Input. Input never changes between parts of a problem.
 		std::string line;
-		std::vector<std::string> tokens;
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
-			StringUtil::SplitBy(line, "=|,| ", tokens);
-			assert(tokens.size() == 6);
-			Robot newBot;
-			newBot.pos.x = atoi(tokens[1].c_str());
-			newBot.pos.y = atoi(tokens[2].c_str());
-			newBot.vel.x = atoi(tokens[4].c_str());
-			newBot.vel.y = atoi(tokens[5].c_str());
-
-			m_robots.push_back(newBot);
+
+			// Optional "board=w,h" line for inputs that aren't on the constructor's board, e.g. the 11x7 example.
+			static const char BOARD_PREFIX[] = "board=";
+			if (line.compare(0, sizeof(BOARD_PREFIX) - 1, BOARD_PREFIX) == 0)
+			{
+				char* next = nullptr;
+				m_boardWidth = (int32_t)strtol(line.c_str() + sizeof(BOARD_PREFIX) - 1, &next, 10);
+				m_boardHeight = (int32_t)strtol(next + 1, &next, 10);
+				continue;
+			}
+
+			const char* cursor = strchr(line.c_str(), '=');
+			if (!cursor)
+			{
+				continue;
+			}
+
+			// p=x,y v=x,y
+			char* next = nullptr;
+			m_robots.posX.push_back((int32_t)strtol(cursor + 1, &next, 10));
+			m_robots.posY.push_back((int32_t)strtol(next + 1, &next, 10));
+			cursor = strchr(next, '=');
+			assert(cursor);
+			m_robots.velX.push_back((int32_t)strtol(cursor + 1, &next, 10));
+			m_robots.velY.push_back((int32_t)strtol(next + 1, &next, 10));
 		}
 
+		assert(m_boardWidth > 0 && m_boardHeight > 0);
+		for (size_t i = 0; i < m_robots.Size(); ++i)
+		{
+			m_robots.velX[i] = ((m_robots.velX[i] % m_boardWidth) + m_boardWidth) % m_boardWidth;
+			m_robots.velY[i] = ((m_robots.velY[i] % m_boardHeight) + m_boardHeight) % m_boardHeight;
+		}
 	}
 
-	void Simulate(int32_t numSteps, std::vector<IntVec2>& outPos) const
+	// Moves robots [begin, end) numSteps forward and adds them to snapshot. offsetsX[v] is v * numSteps mod width (and
+	// likewise for y), so the divisions happen once per distinct velocity rather than once per robot.
+	void SimulateRange(size_t begin, size_t end, const int32_t* offsetsX, const int32_t* offsetsY, BoardSnapshot& snapshot) const
 	{
-		outPos.clear();
-		outPos.reserve(m_robots.size());
-		for (const Robot& rbt : m_robots)
+		const int32_t halfX = (m_boardWidth - 1) / 2;
+		const int32_t halfY = (m_boardHeight - 1) / 2;
+		const bool wantOccupancy = !snapshot.occupancy.empty();
+
+		auto addRobot = [&](int32_t x, int32_t y)
+		{
+			if (x != halfX && y != halfY)
+			{
+				++snapshot.quadrants[(y > halfY ? 2 : 0) + (x > halfX ? 1 : 0)];
+			}
+
+			if (wantOccupancy)
+			{
+				snapshot.occupancy[(size_t)y * snapshot.rowWords + (x >> 6)] |= 1ULL << (x & 63);
+			}
+		};
+
+		size_t i = begin;
+#if defined(__AVX2__)
+		const __m256i width = _mm256_set1_epi32(m_boardWidth - 1);
+		const __m256i height = _mm256_set1_epi32(m_boardHeight - 1);
+		const __m256i widthStep = _mm256_set1_epi32(m_boardWidth);
+		const __m256i heightStep = _mm256_set1_epi32(m_boardHeight);
+		const __m256i halfXVec = _mm256_set1_epi32(halfX);
+		const __m256i halfYVec = _mm256_set1_epi32(halfY);
+		__m256i quadrantCounts[4] = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+		alignas(32) int32_t laneX[8];
+		alignas(32) int32_t laneY[8];
+
+		for (; i + 8 <= end; i += 8)
 		{
-			int32_t xRem = (rbt.pos.x + (rbt.vel.x * numSteps)) % BOARD_WIDTH;
-			int32_t yRem = (rbt.pos.y + (rbt.vel.y * numSteps)) % BOARD_HEIGHT;
+			__m256i x = _mm256_loadu_si256((const __m256i*)&m_robots.posX[i]);
+			__m256i y = _mm256_loadu_si256((const __m256i*)&m_robots.posY[i]);
+			const __m256i dx = _mm256_i32gather_epi32(offsetsX, _mm256_loadu_si256((const __m256i*)&m_robots.velX[i]), 4);
+			const __m256i dy = _mm256_i32gather_epi32(offsetsY, _mm256_loadu_si256((const __m256i*)&m_robots.velY[i]), 4);
+			x = _mm256_add_epi32(x, dx);
+			y = _mm256_add_epi32(y, dy);
+			x = _mm256_sub_epi32(x, _mm256_and_si256(_mm256_cmpgt_epi32(x, width), widthStep));
+			y = _mm256_sub_epi32(y, _mm256_and_si256(_mm256_cmpgt_epi32(y, height), heightStep));
 
-			if (xRem < 0)
+			// Compare masks are -1 per lane, so subtracting them counts.
+			const __m256i left = _mm256_cmpgt_epi32(halfXVec, x);
+			const __m256i right = _mm256_cmpgt_epi32(x, halfXVec);
+			const __m256i top = _mm256_cmpgt_epi32(halfYVec, y);
+			const __m256i bottom = _mm256_cmpgt_epi32(y, halfYVec);
+			quadrantCounts[0] = _mm256_sub_epi32(quadrantCounts[0], _mm256_and_si256(top, left));
+			quadrantCounts[1] = _mm256_sub_epi32(quadrantCounts[1], _mm256_and_si256(top, right));
+			quadrantCounts[2] = _mm256_sub_epi32(quadrantCounts[2], _mm256_and_si256(bottom, left));
+			quadrantCounts[3] = _mm256_sub_epi32(quadrantCounts[3], _mm256_and_si256(bottom, right));
+
+			if (wantOccupancy)
 			{
-				xRem = BOARD_WIDTH + xRem;
+				_mm256_store_si256((__m256i*)laneX, x);
+				_mm256_store_si256((__m256i*)laneY, y);
+				for (uint32_t lane = 0; lane < 8; ++lane)
+				{
+					snapshot.occupancy[(size_t)laneY[lane] * snapshot.rowWords + (laneX[lane] >> 6)] |= 1ULL << (laneX[lane] & 63);
+				}
 			}
+		}
 
-			if (yRem < 0)
+		for (uint32_t quadrant = 0; quadrant < 4; ++quadrant)
+		{
+			alignas(32) uint32_t counts[8];
+			_mm256_store_si256((__m256i*)counts, quadrantCounts[quadrant]);
+			for (uint32_t count : counts)
 			{
-				yRem = BOARD_HEIGHT + yRem;
+				snapshot.quadrants[quadrant] += count;
 			}
+		}
+#endif
 
-			outPos.emplace_back(xRem, yRem);
+		for (; i < end; ++i)
+		{
+			int32_t x = m_robots.posX[i] + offsetsX[m_robots.velX[i]];
+			int32_t y = m_robots.posY[i] + offsetsY[m_robots.velY[i]];
+			x -= x >= m_boardWidth ? m_boardWidth : 0;
+			y -= y >= m_boardHeight ? m_boardHeight : 0;
+			addRobot(x, y);
 		}
 	}
 
-	virtual void PartOne(const AdventGUIContext& context) override
+	// Positions after numSteps, split across threads in big chunks with per thread snapshots merged at the end.
+	void Simulate(int64_t numSteps, bool wantOccupancy, BoardSnapshot& outSnapshot) const
 	{
-		// Part One
-		int32_t quadCount[4] = { 0, 0, 0, 0};
+		std::vector<int32_t> offsetsX(m_boardWidth);
+		std::vector<int32_t> offsetsY(m_boardHeight);
+		const int64_t stepsX = numSteps % m_boardWidth;
+		const int64_t stepsY = numSteps % m_boardHeight;
+		for (int32_t v = 0; v < m_boardWidth; ++v)
+		{
+			offsetsX[v] = (int32_t)((v * stepsX) % m_boardWidth);
+		}
+		for (int32_t v = 0; v < m_boardHeight; ++v)
+		{
+			offsetsY[v] = (int32_t)((v * stepsY) % m_boardHeight);
+		}
 
-		const int32_t halfX = (BOARD_WIDTH - 1) / 2;
-		const int32_t halfY = (BOARD_HEIGHT - 1) / 2;
+		BoardSnapshot empty;
+		empty.rowWords = (uint32_t)((m_boardWidth + 63) / 64);
+		if (wantOccupancy)
+		{
+			empty.occupancy.assign((size_t)empty.rowWords * m_boardHeight, 0);
+		}
 
-		std::vector<IntVec2> outPos;
-		Simulate(100, outPos);
+		std::vector<BoardSnapshot> threadSnapshots(Parallel::GetNumThreads(), empty);
+		Parallel::For(m_robots.Size(), 1 << 16, [&](uint32_t threadIndex, size_t begin, size_t end)
+		{
+			SimulateRange(begin, end, offsetsX.data(), offsetsY.data(), threadSnapshots[threadIndex]);
+		});
 
-		for (const IntVec2& pos : outPos)
+		outSnapshot = empty;
+		for (const BoardSnapshot& snapshot : threadSnapshots)
 		{
-			if (pos.y < halfY)
+			for (uint32_t quadrant = 0; quadrant < 4; ++quadrant)
 			{
-				if (pos.x < halfX)
-				{
-					quadCount[0]++;
-				}
-				else if (pos.x > halfX)
-				{
-					quadCount[1]++;
-				}
+				outSnapshot.quadrants[quadrant] += snapshot.quadrants[quadrant];
 			}
-			else if (pos.y > halfY)
+
+			for (size_t word = 0; word < outSnapshot.occupancy.size(); ++word)
 			{
-				if (pos.x < halfX)
-				{
-					quadCount[2]++;
-				}
-				else if (pos.x > halfX)
-				{
-					quadCount[3]++;
-				}
+				outSnapshot.occupancy[word] |= snapshot.occupancy[word];
 			}
 		}
+	}
+
+	virtual void PartOne(const AdventGUIContext& context) override
+	{
+		// Part One
+		BoardSnapshot snapshot;
+		Simulate(100, false, snapshot);
 
-		int64_t total = (int64_t)quadCount[0] * (int64_t)quadCount[1] * (int64_t)quadCount[2] * (int64_t)quadCount[3];
-		Log("Result = %lld", total);
+		// Overflows 64 bits past a few hundred thousand robots.
+		const UInt128 total = UInt128::Multiply((uint64_t)snapshot.quadrants[0] * snapshot.quadrants[1], (uint64_t)snapshot.quadrants[2] * snapshot.quadrants[3]);
+		char totalBuffer[48];
+		Log("Result = %s", total.ToString(totalBuffer, sizeof(totalBuffer)));
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
 	}
 
-	void ToBytes(const std::vector<IntVec2>& data, std::vector<Bitfield128>& outFields) const
+	// Robots move independently along each axis, so x positions repeat every m_boardWidth steps and y positions every
+	// m_boardHeight steps. A picture shows up as an axis whose positions suddenly bunch together, i.e. a variance dip.
+	// Returns the step in [0, modulus) with the smallest variance.
+	static int32_t FindTightestStep(std::vector<int32_t> positions, const std::vector<int32_t>& steps, int32_t modulus, double& outVariance)
+	{
+		const double count = (double)std::max<size_t>(positions.size(), 1);
+		int32_t bestStep = 0;
+		outVariance = std::numeric_limits<double>::max();
+		for (int32_t step = 0; step < modulus; ++step)
+		{
+			uint64_t sum = 0;
+			uint64_t sumSquares = 0;
+			for (size_t i = 0; i < positions.size(); ++i)
+			{
+				const uint64_t pos = (uint64_t)positions[i];
+				sum += pos;
+				sumSquares += pos * pos;
+
+				int32_t next = positions[i] + steps[i];
+				positions[i] = next >= modulus ? next - modulus : next;
+			}
+
+			const double mean = (double)sum / count;
+			const double variance = (double)sumSquares / count - mean * mean;
+			if (variance < outVariance)
+			{
+				outVariance = variance;
+				bestStep = step;
+			}
+		}
+
+		return bestStep;
+	}
+
+	// Returns gcd(a, b) and x with a * x = gcd (mod b).
+	static int64_t ExtendedGcd(int64_t a, int64_t b, int64_t& outX)
 	{
-		outFields.clear();
-		outFields.insert(outFields.begin(), BOARD_HEIGHT, Bitfield128(0ULL, 0ULL));
+		int64_t oldR = a, r = b;
+		int64_t oldX = 1, x = 0;
+		while (r != 0)
+		{
+			const int64_t quotient = oldR / r;
+			int64_t temp = oldR - quotient * r;
+			oldR = r;
+			r = temp;
+			temp = oldX - quotient * x;
+			oldX = x;
+			x = temp;
+		}
+		outX = oldX;
+		return oldR;
+	}
 
-		for (const IntVec2& pos : data)
+	// Smallest t >= 0 with t = a (mod m) and t = b (mod n), or -1 when the two can't agree (only possible when m and n
+	// share a factor).
+	static int64_t CombineCRT(int64_t a, int64_t m, int64_t b, int64_t n)
+	{
+		int64_t inverse = 0;
+		const int64_t g = ExtendedGcd(m, n, inverse);
+		if ((b - a) % g != 0)
 		{
-			outFields[pos.y].SetBit(pos.x);
+			return -1;
 		}
+
+		// t = a + m * k, m * k = b - a (mod n)  =>  k = (b - a) / g * inverse (mod n / g)
+		const int64_t ng = n / g;
+		int64_t k = ((b - a) / g % ng) * (inverse % ng) % ng;
+		k = (k + ng) % ng;
+		const int64_t lcm = m * ng;
+		return ((a + m * k) % lcm + lcm) % lcm;
 	}
 
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
-		bool treeDetected = false;
-		int32_t numSteps = 0;
-
-		const int32_t halfX = (BOARD_WIDTH - 1) / 2;
-		const int32_t halfY = (BOARD_HEIGHT - 1) / 2;
+		double varianceX = 0.0;
+		double varianceY = 0.0;
+		const int32_t stepX = FindTightestStep(m_robots.posX, m_robots.velX, m_boardWidth, varianceX);
+		const int32_t stepY = FindTightestStep(m_robots.posY, m_robots.velY, m_boardHeight, varianceY);
 
-		std::vector<IntVec2> outPos;	
-		std::vector<Bitfield128> bits;
-		while (!treeDetected)
+		int64_t numSteps = CombineCRT(stepX, m_boardWidth, stepY, m_boardHeight);
+		if (numSteps < 0)
 		{
-			Simulate(++numSteps, outPos);
-
-			ToBytes(outPos, bits);
+			// Board sides share a factor and the two dips never line up, settle for the x dip.
+			numSteps = stepX;
+		}
 
-			// Search for a group of contiguous values (5 is entirely arbitrary)
-			for (size_t i = 0; i < BOARD_HEIGHT-1; ++i)
-			{
-				Bitfield128 AB = bits[i] & bits[i + 1];
-				uint32_t bitIndex = 0;
-				uint32_t contiguousSize = 0;
-				while (!AB.IsZero())
-				{
-					Bits::GetContiguousBitsLSB128(AB, bitIndex, contiguousSize);
-					if (contiguousSize >= 5)
-					{
-						Bitfield128 C = bits[i + 2] & Bits::CreateBitMask128(bitIndex, contiguousSize);
-						if (Bits::PopCount128(C) == contiguousSize) // 5 x 3 at the least, probably it.
-						{
-							treeDetected = true;
-							break;
-						}
-					}
-
-					// Clear the bits, move on.
-					AB &= ~Bits::CreateBitMask128(bitIndex, contiguousSize);
-				}
-			}
+		BoardSnapshot snapshot;
+		Simulate(numSteps, true, snapshot);
+		uint32_t numOccupied = 0;
+		for (uint64_t word : snapshot.occupancy)
+		{
+			numOccupied += Bits::PopCount64(word);
 		}
 
-		Log("Tree found on Step %d", numSteps);
+		Log("Tree found on Step %lld (x dip at %d, variance %.1f, y dip at %d, variance %.1f, %u cells occupied)", numSteps, stepX, varianceX, stepY, varianceY, numOccupied);
 
 		// Done.
 		AdventGUIInstance::PartTwo(context);
 	}
 
-	const int32_t BOARD_WIDTH = 101;
-	const int32_t BOARD_HEIGHT = 103;
-	std::vector<Robot> m_robots;
+	int32_t m_boardWidth;
+	int32_t m_boardHeight;
+	RobotArrays m_robots;
 };
 
 int main()
@@ -175,7 +339,7 @@ int main()
 	newParams.puzzleTitle = "Restroom Redoubt";
 	newParams.inputFilename = "input.txt";
 
-	AdventGUIInstance::InstantiateAndExecute<AdventDay>(newParams);
+	AdventGUIInstance::InstantiateAndExecute<AdventDay>(newParams, 101, 103);
 
 	return 0;
 }
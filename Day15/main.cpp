@@ -1,5 +1,4 @@
 #include "AdventGUI/AdventGUI.h"
-#include "ACUtils/Algorithm.h"
 #include "ACUtils/IntVec.h"
 
 
@@ -13,7 +12,6 @@ private:
 	{
 		// Parse Input. Input never changes between parts of a problem.
 		std::string line;
-		std::vector<std::string> tokens;
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
@@ -52,305 +50,186 @@ private:
 
 	}
 
-	char GetData(const std::vector<char>& state, const IntVec2& pos, int32_t mapWidth) const
+	// Simulates the warehouse in place. Walls and boxes are separate bitboards over the (possibly widened) grid, with a
+	// box stored as the bit of its leftmost cell. A push gathers the boxes it moves with a BFS, then rewrites only their
+	// bits, and the GPS sum moves by the same delta for every box shifted, so a move costs the size of the chain it
+	// pushes and nothing else.
+	class Warehouse
 	{
-		return state[pos.y * mapWidth + pos.x];
-	}
-
-	bool CanShift(const std::vector<char>& state, const IntVec2& pos, const IntVec2& dir, uint8_t& outSteps) const
-	{
-		IntVec2 nextPos = pos + dir;
-		char c = '\0';
-		outSteps = 0;
-		while (true)
+	public:
+		Warehouse(const std::vector<char>& map, size_t mapWidth, const IntVec2& startPos, int32_t boxWidth)
+		: m_width((int32_t)mapWidth * boxWidth),
+		m_boxWidth(boxWidth),
+		m_gpsSum(0),
+		m_generation(0)
 		{
-			char c = GetData(state, nextPos, m_mapWidth);
-			if (c == '.')
-			{
-				return true;
-			}
+			const size_t numCells = map.size() * boxWidth;
+			m_walls.assign((numCells + 63) / 64, 0);
+			m_boxes.assign((numCells + 63) / 64, 0);
+			m_visited.assign(numCells, 0);
 
-			if (c == '#')
+			for (size_t i = 0; i < map.size(); ++i)
 			{
-				break;
+				const int32_t cell = (int32_t)i * boxWidth;
+				if (map[i] == '#')
+				{
+					for (int32_t part = 0; part < boxWidth; ++part)
+					{
+						SetBit(m_walls, cell + part);
+					}
+				}
+				else if (map[i] == 'O')
+				{
+					SetBit(m_boxes, cell);
+					m_gpsSum += GetGPS(cell);
+				}
 			}
 
-			assert(c == 'O');
-			nextPos += dir;
-			++outSteps;
+			m_robot = startPos.y * m_width + startPos.x * boxWidth;
 		}
 
-		return false;
-	}
-
-
-	void Step(const std::vector<char>& state, const IntVec2& pos, const IntVec2& dir, int32_t mapWidth, std::vector<char>& outSim, IntVec2& outPos) const
-	{
-		assert(state.size() == outSim.size());
-		memcpy(outSim.data(), state.data(), sizeof(char) * state.size());
-
-		IntVec2 delta = pos + dir;
-		uint8_t numSteps = 0;
-		char c = GetData(state, delta, mapWidth);
-		switch (c)
+		void Move(char instruction)
 		{
-			case '.':
+			int32_t delta = 0;
+			switch (instruction)
 			{
-				outPos = delta;
+			case '<': delta = -1; break;
+			case '>': delta = 1; break;
+			case '^': delta = -m_width; break;
+			case 'v': delta = m_width; break;
+			default: assert(false); return;
 			}
-			break;
-			case '#':
+
+			const int32_t target = m_robot + delta;
+			if (TestBit(m_walls, target))
 			{
-				outPos = pos;
+				return;
 			}
-			break;
-			case 'O':
-			{
-				if (CanShift(state, pos, dir, numSteps))
-				{
-					IntVec2 stepPos;
-					for(uint8_t i = 0; i < numSteps; ++i)
-					{
-						stepPos = delta + dir * (int32_t)(i + 1);
-						outSim[stepPos.y * m_mapWidth + stepPos.x] = 'O';
-					}
 
-					outSim[delta.y * m_mapWidth + delta.x] = '.';
-
-					outPos = delta;
-				}
-				else
-				{
-					outPos = pos;
-				}
+			const int32_t firstBox = GetBoxAt(target);
+			if (firstBox < 0)
+			{
+				m_robot = target;
+				return;
 			}
-			break;
-			case '[':
-			case ']':
+
+			// Everything the push touches, in discovery order. Any wall in the way stops the lot.
+			++m_generation;
+			m_chain.clear();
+			m_chain.push_back(firstBox);
+			m_visited[firstBox] = m_generation;
+			for (size_t i = 0; i < m_chain.size(); ++i)
 			{
-				if (dir.y == 0)
+				const int32_t box = m_chain[i];
+				for (int32_t part = 0; part < m_boxWidth; ++part)
 				{
-					if (CanMoveHorizontal(state, pos, dir, mapWidth))
-					{
-						HorizontalMove(state, pos, '.', dir, mapWidth, outSim);
-
-						outPos = delta;
-					}
-					else
+					const int32_t next = box + part + delta;
+					if (TestBit(m_walls, next))
 					{
-						outPos = pos;
+						return;
 					}
 
-				}
-				else
-				{
-					if (CanMoveVertically(state, pos, dir, mapWidth) && CanMoveVertically(state, pos + (c == ']' ? IntVec2(-1, 0) : IntVec2(1, 0)), dir, mapWidth))
-					{
-						MoveVertically(pos, dir, mapWidth, outSim);
-						//VerticalMove(state, pos,  dir, mapWidth, outSim);
-						//IntVec2 ddx = pos + (c == ']' ? IntVec2(-1, 0) : IntVec2(1, 0)) + dir;
-						//outSim[ddx.y * mapWidth + ddx.x] = '.';
-			
-						outPos = delta;
-					}
-					else
+					const int32_t nextBox = GetBoxAt(next);
+					if (nextBox >= 0 && m_visited[nextBox] != m_generation)
 					{
-						outPos = pos;
+						m_visited[nextBox] = m_generation;
+						m_chain.push_back(nextBox);
 					}
 				}
+			}
 
+			// Clear first so boxes moving into each other's old cells don't get wiped.
+			for (int32_t box : m_chain)
+			{
+				ClearBit(m_boxes, box);
+			}
+			for (int32_t box : m_chain)
+			{
+				SetBit(m_boxes, box + delta);
 			}
-			break;
-			default: 
-			assert(false); 
-			break;
-		}
-	}
 
-	virtual void PartOne(const AdventGUIContext& context) override
-	{
-		// Part One
-		std::vector<char> pingPong[2] = {m_map, m_map};
-		int32_t ppIdx = 0;
-		IntVec2 dir;
+			// A row is worth 100, a column 1.
+			const int64_t gpsDelta = delta == m_width ? 100 : delta == -m_width ? -100 : delta;
+			m_gpsSum += gpsDelta * (int64_t)m_chain.size();
+			m_robot = target;
+		}
 
-		IntVec2 currPos = m_startPos;
-		IntVec2 nextPos;
+		int64_t GetGPSSum() const { return m_gpsSum; }
 
-		for (size_t i = 0; i < m_input.size(); ++i)
+	private:
+		int64_t GetGPS(int32_t cell) const
 		{
-			switch (m_input[i])
-			{
-				case '<': dir = IntVec2(-1, 0); break;
-				case '>': dir = IntVec2(1, 0); break;
-				case '^': dir = IntVec2(0, -1); break;
-				case 'v': dir = IntVec2(0, 1); break;
-				default: assert(false); break;
-			}
-
-			Step(pingPong[ppIdx], currPos, dir, m_mapWidth, pingPong[ppIdx ^ 1], nextPos);
-			//Log("Step %zd: Pos [%d, %d] -> [%d, %d]", i + 1, currPos.x, currPos.y, nextPos.x, nextPos.y);
-			currPos = nextPos;
-			ppIdx^=1;
+			return (int64_t)(cell / m_width) * 100 + cell % m_width;
 		}
 
-		uint32_t GPSSum = 0;
-		const std::vector<char>& lastState = pingPong[ppIdx ^ 1];
-		for (size_t i = 0; i < lastState.size(); ++i)
+		// Left cell of the box covering cell, or -1.
+		int32_t GetBoxAt(int32_t cell) const
 		{
-			if (lastState[i] == 'O')
+			if (TestBit(m_boxes, cell))
 			{
-				GPSSum += (i / m_mapWidth) * 100 + i % m_mapWidth;
+				return cell;
 			}
-		}
-
-		Log("GPS Sum = %u", GPSSum);
-
-		// Done.
-		AdventGUIInstance::PartOne(context);
-	}
 
-	void Expand(const std::vector<char>& inMap, std::vector<char>& outMap) const
-	{
-		outMap.reserve(inMap.size() * 2);
-		for (char c : inMap)
-		{
-			switch (c)
+			if (m_boxWidth == 2 && TestBit(m_boxes, cell - 1))
 			{
-			case '#':outMap.insert(outMap.end(), 2, '#'); break;
-			case 'O':outMap.insert(outMap.end(), '['); outMap.insert(outMap.end(), ']'); break;
-			case '.':outMap.insert(outMap.end(), 2, '.'); break;
-			default: assert(false); break;
+				return cell - 1;
 			}
+
+			return -1;
 		}
-	}
 
-	bool CanMoveHorizontal(const std::vector<char>& state, const IntVec2& boxPos, const IntVec2& dir, int32_t mapWidth) const
-	{
-		IntVec2 ddx = boxPos + dir;
-		switch(GetData(state, ddx, mapWidth))
+		static bool TestBit(const std::vector<uint64_t>& bits, int32_t index)
 		{
-		case '#': return false;
-		case '.': return true;
-		default: break;
+			return (bits[index / 64] >> (index % 64)) & 1;
 		}
 
-		return CanMoveHorizontal(state, ddx, dir, mapWidth);
-	}
-
-	bool CanMoveVertically(const std::vector<char>& state, const IntVec2& boxPos, const IntVec2& dir, int32_t mapWidth) const
-	{
-		IntVec2 ddy = boxPos + dir;
-		switch (GetData(state, ddy, mapWidth))
+		static void SetBit(std::vector<uint64_t>& bits, int32_t index)
 		{
-			case '#': return false;
-			case '.': return true;
-			case '[':
-			{
-				return CanMoveVertically(state, ddy, dir, mapWidth) && CanMoveVertically(state, ddy + IntVec2(1,0), dir, mapWidth);
-			}
-			break;
-			default:
-			break;
+			bits[index / 64] |= 1ULL << (index % 64);
 		}
 
-		return CanMoveVertically(state, ddy, dir, mapWidth) && CanMoveVertically(state, ddy + IntVec2(-1, 0), dir, mapWidth);
-	}
-
-	void HorizontalMove(const std::vector<char>& state, const IntVec2& boxPos, char c, const IntVec2& dir, int32_t mapWidth, std::vector<char>& outState) const
-	{
-		assert(dir.y == 0);
-		// ...[][]@ <
-		IntVec2 ddx = boxPos + dir;
-		char curr = GetData(state, ddx, mapWidth);
-
-		if (curr != '.')
+		static void ClearBit(std::vector<uint64_t>& bits, int32_t index)
 		{
-			HorizontalMove(state, ddx, curr, dir, mapWidth, outState);
+			bits[index / 64] &= ~(1ULL << (index % 64));
 		}
 
-		outState[ddx.y * mapWidth + ddx.x] = c;
-		outState[boxPos.y * mapWidth + boxPos.x] = '.';
-	}
+		int32_t m_width;
+		int32_t m_boxWidth;
+		int32_t m_robot;
+		int64_t m_gpsSum;
+		std::vector<uint64_t> m_walls;
+		std::vector<uint64_t> m_boxes;
 
+		// Push scratch, m_visited is stamped with m_generation so it never needs clearing.
+		std::vector<int32_t> m_chain;
+		std::vector<uint32_t> m_visited;
+		uint32_t m_generation;
+	};
 
-	void MoveVertically(const IntVec2& pos, const IntVec2& dir, int32_t mapWidth, std::vector<char>& outSim) const
+	int64_t Simulate(int32_t boxWidth) const
 	{
-		IntVec2 ddy = pos + dir;
-		char c = GetData(outSim, ddy, mapWidth);
-		if (c == '[' || c == ']')
+		Warehouse warehouse(m_map, m_mapWidth, m_startPos, boxWidth);
+		for (char instruction : m_input)
 		{
-			MoveVertically(ddy + (c == ']' ? IntVec2(-1, 0) : IntVec2(1, 0)), dir, mapWidth, outSim);
-			MoveVertically(ddy, dir, mapWidth, outSim);
+			warehouse.Move(instruction);
 		}
-		outSim[ddy.y * mapWidth + ddy.x] = outSim[pos.y * mapWidth + pos.x];
-		outSim[pos.y * mapWidth + pos.x] = '.';
+
+		return warehouse.GetGPSSum();
 	}
 
-	void PrintState(const std::vector<char>& state, const IntVec2& playerPos, int32_t mapWidth) const
+	virtual void PartOne(const AdventGUIContext& context) override
 	{
-		int32_t mapHeight = (int32_t)state.size() / mapWidth;
-		std::string formattedString;
-		formattedString.reserve(state.size() + m_mapHeight + 1);
-		formattedString.insert(formattedString.end(), '\n');
-		for (int i = 0; i < mapHeight; ++i)
-		{
-			formattedString.insert(formattedString.size(), state.data() + i * mapWidth, mapWidth);
-			if (i == playerPos.y)
-			{
-				formattedString[formattedString.size() - (mapWidth - playerPos.x)] = '@';
-			}
-			formattedString.insert(formattedString.end(), '\n');
-		}
+		// Part One
+		Log("GPS Sum = %lld", Simulate(1));
 
-		Log("%s", formattedString.c_str());
+		// Done.
+		AdventGUIInstance::PartOne(context);
 	}
 
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
-		std::vector<char> bigMap;
-		Expand(m_map, bigMap);
-
-		std::vector<char> pingPong[2] = { bigMap, bigMap };
-		int32_t ppIdx = 0;
-		IntVec2 dir;
-
-		IntVec2 currPos = m_startPos;
-		currPos.x *= 2;
-		IntVec2 nextPos;
-		
-		//PrintState(pingPong[0], currPos, m_mapWidth * 2);
-
-		for (size_t i = 0; i < m_input.size(); ++i)
-		{
-			switch (m_input[i])
-			{
-			case '<': dir = IntVec2(-1, 0); break;
-			case '>': dir = IntVec2(1, 0); break;
-			case '^': dir = IntVec2(0, -1); break;
-			case 'v': dir = IntVec2(0, 1); break;
-			default: assert(false); break;
-			}
-
-			Step(pingPong[ppIdx], currPos, dir, m_mapWidth * 2, pingPong[ppIdx ^ 1], nextPos);
-			//Log("Step %zd: Pos [%d, %d] -> [%d, %d]", i + 1, currPos.x, currPos.y, nextPos.x, nextPos.y);
-			//PrintState(pingPong[ppIdx ^ 1], nextPos, m_mapWidth * 2);
-			currPos = nextPos;
-			ppIdx ^= 1;
-		}
-
-		uint32_t GPSSum = 0;
-		const std::vector<char>& lastState = pingPong[ppIdx ^ 1];
-		for (size_t i = 0; i < lastState.size(); ++i)
-		{
-			if (lastState[i] == '[')
-			{
-				GPSSum += (i / (m_mapWidth * 2)) * 100 + i % (m_mapWidth * 2);
-			}
-		}
-
-		Log("GPS Sum = %u", GPSSum);
+		Log("GPS Sum = %lld", Simulate(2));
 
 		// Done.
 		AdventGUIInstance::PartTwo(context);
@@ -1,271 +1,260 @@
 #include "AdventGUI/AdventGUI.h"
-#include "ACUtils/Algorithm.h"
 #include "ACUtils/IntVec.h"
-#include "ACUtils/AStar.h"
+#include <intrin.h>
 
-using namespace AStar;
-
-enum class Direction : size_t
-{
-	North = 0,
-	East,
-	South,
-	West
-};
-
-class PathState : public AStarNodeBase<uint32_t>
+class AdventDay : public AdventGUIInstance
 {
 public:
-	PathState(const IntVec2& pos, const Direction dir, const IntVec2& goal) :AStarNodeBase<uint32_t>(0, 0), m_hash(0), m_pos(pos), m_goalPos(goal), m_dir(dir)
-	{
-		m_hash = pos.x | pos.y << 8 | (static_cast<size_t>(dir) << 16);
-	}
-	virtual size_t GetHash() const override { return m_hash; }
-	virtual bool IsAtGoal() const override { return false; /* m_pos == m_goalPos; */} // For part two.
-	const IntVec2& GetPos() const { return m_pos; }
-	const Direction GetDirection() const { return m_dir; }
-public:
-	size_t m_hash;
-	IntVec2 m_pos;
-	IntVec2 m_goalPos;
-	Direction m_dir;
-};
+	AdventDay(const AdventGUIParams& params) : AdventGUIInstance(params) {};
 
-class GridExecutor : public AStarExecuter<uint32_t>
-{
-public:
-	GridExecutor(const std::vector<char>& mapData, size_t mapWidth, const IntVec2& goal)
-	: m_mapData(mapData),
-	m_mapWidth(mapWidth),
-	m_mapHeight(mapData.size() / mapWidth),
-	m_goalPos(goal),
-	m_lowestGoalScore(~0ULL)
-	{
-	}
-	
-	virtual void OnProcessNode(AStarNodeBase<uint32_t>& CurrentNode) override
+private:
+	virtual void ParseInput(FileStreamReader& fileReader) override
 	{
-		PathState* pathNode = CurrentNode.As<PathState>();
-		assert(pathNode);
-
-		static Direction dirs[] = { Direction::North, Direction::East, Direction::South, Direction::West };
-		static IntVec2 dirVec[] = { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
-
-		const IntVec2& currentPos = pathNode->GetPos();
-		const Direction currentDir = pathNode->GetDirection();
-		const uint32_t currentCost = pathNode->GetCost();
-
-		if (pathNode->GetPos() == m_goalPos)
+		// Parse Input. Input never changes between parts of a problem.
+		std::string line;
+		m_mapWidth = 0;
+		while (!fileReader.IsEOF())
 		{
-			if (pathNode->GetTotalCost() < m_lowestGoalScore)
+			line = fileReader.ReadLine();
+			if (line.empty())
 			{
-				m_lowestGoalScore = pathNode->GetTotalCost();
-				m_validPositions.clear();
+				continue;
 			}
-			
-			if (pathNode->GetTotalCost() == m_lowestGoalScore)
+
+			if (m_mapWidth == 0)
 			{
-				const AStarNodeBase<uint32_t>* currState = pathNode;
-				while (currState)
+				m_mapWidth = line.size();
+			}
+			assert(m_mapWidth == line.size());
+		
+			if (m_startPos.IsZero())
+			{
+				size_t foundIndex = line.find('S');
+				if (foundIndex != std::string::npos)
 				{
-					m_validPositions.insert(currState->As<PathState>()->GetPos());
-					currState = currState->GetParent();
+					m_startPos.y = (int32_t)(m_map.size() / m_mapWidth);
+					m_startPos.x = (int32_t)foundIndex;
+					line[foundIndex] = '.';
 				}
 			}
 
-			return;
+			if (m_goalPos.IsZero())
+			{
+				size_t foundIndex = line.find('E');
+				if (foundIndex != std::string::npos)
+				{
+					m_goalPos.y = (int32_t)(m_map.size() / m_mapWidth);
+					m_goalPos.x = (int32_t)foundIndex;
+					line[foundIndex] = '.';
+				}
+			}
+			
+			m_map.insert(m_map.end(), line.begin(), line.end());
 		}
 
-		// 3 options, forward, left, right
-		Direction cw = static_cast<Direction>((static_cast<size_t>(currentDir) + 1) % 4);
-		Direction ccw = static_cast<Direction>((static_cast<size_t>(currentDir) + 3) % 4);
+		m_mapHeight = m_map.size() / m_mapWidth;
 
-		PathState* cwState = new PathState(currentPos, cw, m_goalPos);
-		cwState->SetCost(pathNode->GetCost() + 1000);
-		cwState->SetHeuristic(pathNode->GetHeuristic());
-		cwState->SetParent(pathNode);
+		Solve();
+	}
 
-		PathState* ccwState = new PathState(currentPos, ccw, m_goalPos);
-		ccwState->SetCost(pathNode->GetCost() + 1000);
-		ccwState->SetHeuristic(pathNode->GetHeuristic());
-		ccwState->SetParent(pathNode);
+	// Dial style bucket queue for Dijkstra with edge costs up to MAX_EDGE_COST. Every queued cost sits within
+	// MAX_EDGE_COST of the last one popped, so a ring of buckets indexed by cost covers them all in order. Non empty
+	// buckets are tracked in a two level bitmap (a summary word over 16 bucket words), so finding the next one is a couple
+	// of bit scans rather than a walk over up to 1000 empty buckets.
+	class BucketQueue
+	{
+	public:
+		enum : uint32_t { NUM_BUCKETS = 1024, MAX_EDGE_COST = NUM_BUCKETS - 1 };
 
-		PathState * forwardState = new PathState(currentPos + dirVec[static_cast<size_t>(currentDir)], currentDir, m_goalPos);
-		forwardState->SetCost(pathNode->GetCost() + 1);
-		forwardState->SetHeuristic(GetHeuristic(forwardState->GetPos()));
-		forwardState->SetParent(pathNode);
+		BucketQueue() : m_summary(0), m_current(0), m_size(0)
+		{
+			memset(m_words, 0, sizeof(m_words));
+		}
 
-		PathState* allNodes[] = { cwState, ccwState, forwardState };
+		bool IsEmpty() const { return m_size == 0; }
 
-		IntVec2 delta;
-		for (PathState* node : allNodes)
+		void Push(uint32_t state, uint32_t cost)
 		{
-			if (node->GetDirection() != pathNode->GetDirection())
-			{
-				delta = currentPos + dirVec[static_cast<size_t>(node->GetDirection())];
-			}
-			else
-			{
-				delta = node->GetPos();
-			}
-
-			if (!IsInMap(delta) || IsBlocked(delta))
-			{
-				continue;
-			}
+			assert(cost >= m_current && cost - m_current <= MAX_EDGE_COST);
+			const uint32_t bucket = cost % NUM_BUCKETS;
+			m_buckets[bucket].push_back(state);
+			m_words[bucket / 64] |= 1ULL << (bucket % 64);
+			m_summary |= 1U << (bucket / 64);
+			++m_size;
+		}
 
-			// Check open list.
-			const AStarNodeBase<uint32_t>* closedNode = GetClosedListNode(node);
-			if (closedNode && closedNode->GetTotalCost() < node->GetTotalCost())
+		void Pop(uint32_t& outState, uint32_t& outCost)
+		{
+			assert(m_size > 0);
+			const uint32_t start = m_current % NUM_BUCKETS;
+			const uint32_t bucket = FindNextBucket(start);
+			m_current += (bucket - start) % NUM_BUCKETS;
+
+			std::vector<uint32_t>& entries = m_buckets[bucket];
+			outState = entries.back();
+			outCost = m_current;
+			entries.pop_back();
+			--m_size;
+			if (entries.empty())
 			{
-				assert(closedNode->As<PathState>()->GetPos() == node->GetPos());
-				// Skip it.
-				delete node;
-				continue;
+				m_words[bucket / 64] &= ~(1ULL << (bucket % 64));
+				if (m_words[bucket / 64] == 0)
+				{
+					m_summary &= ~(1U << (bucket / 64));
+				}
 			}
+		}
 
-			// See if we have a better cost than an existing entry in the open list.
-			int32_t existingIndex = FindIndexInOpenList(node);
-			if (existingIndex != -1)
+	private:
+		// First non empty bucket at or after start, wrapping around the ring.
+		uint32_t FindNextBucket(uint32_t start) const
+		{
+			const uint32_t word = start / 64;
+			const uint64_t sameWord = m_words[word] & (~0ULL << (start % 64));
+			if (sameWord)
 			{
-				AStarNodeBase<uint32_t>* existingNode = m_openList[existingIndex];
-				if (node->GetTotalCost() > existingNode->GetTotalCost())
-				{
-					delete node;
-					continue;
-				}
+				return word * 64 + (uint32_t)_tzcnt_u64(sameWord);
 			}
 
-			InsertNode(node);
+			const uint32_t laterWords = word + 1 < 32 ? m_summary & (~0U << (word + 1)) : 0;
+			const uint32_t nextWord = _tzcnt_u32(laterWords ? laterWords : m_summary);
+			return nextWord * 64 + (uint32_t)_tzcnt_u64(m_words[nextWord]);
 		}
-	}
 
-	bool IsInMap(const IntVec2& pos) const
+		std::vector<uint32_t> m_buckets[NUM_BUCKETS];
+		uint64_t m_words[NUM_BUCKETS / 64];
+		uint32_t m_summary;
+		uint32_t m_current;
+		size_t m_size;
+	};
+
+	// Directions clockwise from East, so +1 / +3 (mod 4) are the two 90 degree turns.
+	static constexpr uint32_t NUM_DIRS = 4;
+	static constexpr uint32_t STEP_COST = 1;
+	static constexpr uint32_t TURN_COST = 1000;
+
+	// Open cell one step from cell in dir (or against it), false for walls and the map edge.
+	bool GetNeighbour(uint32_t cell, uint32_t dir, bool backwards, uint32_t& outCell) const
 	{
-		if (pos.x < 0 || pos.y < 0 || pos.x >= m_mapWidth || pos.y >= m_mapHeight)
+		static const int32_t dirX[NUM_DIRS] = { 1, 0, -1, 0 };
+		static const int32_t dirY[NUM_DIRS] = { 0, 1, 0, -1 };
+		const int32_t sign = backwards ? -1 : 1;
+		const size_t x = cell % m_mapWidth + sign * dirX[dir];
+		const size_t y = cell / m_mapWidth + sign * dirY[dir];
+		if (x >= m_mapWidth || y >= m_mapHeight)
 		{
 			return false;
 		}
 
-		return true;
+		outCell = (uint32_t)(y * m_mapWidth + x);
+		return m_map[outCell] != '#';
 	}
 
-	bool IsBlocked(const IntVec2& pos) const
+	// States are cell * 4 + direction. One forward Dijkstra over the flat cost array gives the best score, then a
+	// backward sweep from the best end states walks every edge that was tight (dist[from] + cost == dist[to]), which is
+	// exactly the DAG of optimal paths, marking the cells it passes through.
+	void Solve()
 	{
-		return m_mapData[pos.y * m_mapWidth + pos.x] == '#';
-	}
-
-	uint32_t GetTurnCost(Direction from, Direction to) const
-	{
-		if (from == to)
-		{
-			 return 0;
-		}
+		const uint32_t numStates = (uint32_t)(m_map.size() * NUM_DIRS);
+		const uint32_t unreached = ~0U;
+		std::vector<uint32_t> dist(numStates, unreached);
 
-		size_t dirDelta = to > from ? (static_cast<size_t>(to) - static_cast<size_t>(from)) : (static_cast<size_t>(from) - static_cast<size_t>(to));
+		BucketQueue queue;
+		const uint32_t startState = (uint32_t)(m_startPos.y * m_mapWidth + m_startPos.x) * NUM_DIRS; // Facing East.
+		dist[startState] = 0;
+		queue.Push(startState, 0);
 
-		if (dirDelta == 2)
+		auto relax = [&](uint32_t state, uint32_t cost)
 		{
-			return 2000;
-		}
+			if (cost < dist[state])
+			{
+				dist[state] = cost;
+				queue.Push(state, cost);
+			}
+		};
 
-		return 1000;
-	}
+		while (!queue.IsEmpty())
+		{
+			uint32_t state = 0;
+			uint32_t cost = 0;
+			queue.Pop(state, cost);
+			if (cost != dist[state])
+			{
+				continue; // Stale entry.
+			}
 
-	uint32_t GetHeuristic(const IntVec2& pos) const
-	{
-		// Manhattan Distance should be fine.
-		return abs(pos.x - m_goalPos.x) + abs(pos.y - m_goalPos.y);
-	}
+			const uint32_t cell = state / NUM_DIRS;
+			const uint32_t dir = state % NUM_DIRS;
+			uint32_t ahead = 0;
+			if (GetNeighbour(cell, dir, false, ahead))
+			{
+				relax(ahead * NUM_DIRS + dir, cost + STEP_COST);
+			}
+			relax(cell * NUM_DIRS + (dir + 1) % NUM_DIRS, cost + TURN_COST);
+			relax(cell * NUM_DIRS + (dir + 3) % NUM_DIRS, cost + TURN_COST);
+		}
 
-	size_t GetLowestScore() const { return m_lowestGoalScore; }
-	const std::unordered_set<IntVec2>& GetLowestScorePaths() const { return m_validPositions; }
+		const uint32_t goalCell = (uint32_t)(m_goalPos.y * m_mapWidth + m_goalPos.x);
+		m_bestScore = unreached;
+		for (uint32_t dir = 0; dir < NUM_DIRS; ++dir)
+		{
+			m_bestScore = std::min(m_bestScore, dist[goalCell * NUM_DIRS + dir]);
+		}
 
-	const std::vector<char> m_mapData;
-	const size_t m_mapWidth;
-	const size_t m_mapHeight;
-	const IntVec2 m_goalPos;
-	size_t m_lowestGoalScore;
-	std::unordered_set<IntVec2> m_validPositions;
-};
+		m_numSeats = 0;
+		if (m_bestScore == unreached)
+		{
+			return;
+		}
 
-class AdventDay : public AdventGUIInstance
-{
-public:
-	AdventDay(const AdventGUIParams& params) : AdventGUIInstance(params) {};
+		std::vector<uint8_t> onPath(numStates, 0);
+		std::vector<uint8_t> seats(m_map.size(), 0);
+		std::vector<uint32_t> stack;
+		for (uint32_t dir = 0; dir < NUM_DIRS; ++dir)
+		{
+			if (dist[goalCell * NUM_DIRS + dir] == m_bestScore)
+			{
+				onPath[goalCell * NUM_DIRS + dir] = 1;
+				stack.push_back(goalCell * NUM_DIRS + dir);
+			}
+		}
 
-private:
-	virtual void ParseInput(FileStreamReader& fileReader) override
-	{
-		// Parse Input. Input never changes between parts of a problem.
-		std::string line;
-		std::vector<std::string> tokens;
-		m_mapWidth = 0;
-		while (!fileReader.IsEOF())
+		auto visitIfTight = [&](uint32_t from, uint32_t edgeCost, uint32_t toCost)
 		{
-			line = fileReader.ReadLine();
-			if (m_mapWidth == 0)
+			if (!onPath[from] && dist[from] != unreached && dist[from] + edgeCost == toCost)
 			{
-				m_mapWidth = line.size();
+				onPath[from] = 1;
+				stack.push_back(from);
 			}
-			assert(m_mapWidth == line.size());
-		
-			if (m_startPos.IsZero())
+		};
+
+		while (!stack.empty())
+		{
+			const uint32_t state = stack.back();
+			stack.pop_back();
+
+			const uint32_t cell = state / NUM_DIRS;
+			const uint32_t dir = state % NUM_DIRS;
+			if (!seats[cell])
 			{
-				size_t foundIndex = line.find('S');
-				if (foundIndex != std::string::npos)
-				{
-					m_startPos.y = (int32_t)(m_map.size() / m_mapWidth);
-					m_startPos.x = (int32_t)foundIndex;
-					line[foundIndex] = '.';
-				}
+				seats[cell] = 1;
+				++m_numSeats;
 			}
 
-			if (m_goalPos.IsZero())
+			uint32_t behind = 0;
+			if (GetNeighbour(cell, dir, true, behind))
 			{
-				size_t foundIndex = line.find('E');
-				if (foundIndex != std::string::npos)
-				{
-					m_goalPos.y = (int32_t)(m_map.size() / m_mapWidth);
-					m_goalPos.x = (int32_t)foundIndex;
-					line[foundIndex] = '.';
-				}
+				visitIfTight(behind * NUM_DIRS + dir, STEP_COST, dist[state]);
 			}
-			
-			m_map.insert(m_map.end(), line.begin(), line.end());
+			visitIfTight(cell * NUM_DIRS + (dir + 1) % NUM_DIRS, TURN_COST, dist[state]);
+			visitIfTight(cell * NUM_DIRS + (dir + 3) % NUM_DIRS, TURN_COST, dist[state]);
 		}
-
-		m_mapHeight = m_map.size() / m_mapWidth;
-
 	}
 
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
-		GridExecutor executer(m_map, m_mapWidth, m_goalPos);
-		PathState* initialNode = new PathState(m_startPos, Direction::East, m_goalPos);
-		initialNode->SetHeuristic(executer.GetHeuristic(m_startPos));
-		executer.InsertNode(initialNode);
-
-		std::vector<const PathState*> solvedPath;
-		const AStarNodeBase<uint32_t>* pathNode = nullptr;
-		if (executer.Solve(pathNode))
-		{
-			// Chain up for the path route
-			while (pathNode)
-			{
-				solvedPath.push_back(pathNode->As<PathState>());
-				pathNode = pathNode->GetParent();
-			}
-
-			Log("Least score = %u", solvedPath[0]->GetCost());
-		}
-		else
-		{
-			// Part Two
-			Log("Lowest Score = %zd", executer.GetLowestScore());
-			Log("Seat Positions = %zd", executer.GetLowestScorePaths().size());
-		}
+		Log("Least score = %u", m_bestScore);
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
@@ -274,6 +263,7 @@ private:
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
+		Log("Seat Positions = %u", m_numSeats);
 
 		// Done.
 		AdventGUIInstance::PartTwo(context);
@@ -284,7 +274,8 @@ private:
 	size_t m_mapWidth;
 	size_t m_mapHeight;
 	std::vector<char> m_map;
-
+	uint32_t m_bestScore = 0;
+	uint32_t m_numSeats = 0;
 };
 
 int main()
@@ -1,6 +1,5 @@
 #include "AdventGUI/AdventGUI.h"
-#include "ACUtils/Algorithm.h"
-#include "ACUtils/IntVec.h"
+#include "ACUtils/Parallel.h"
 
 
 class AdventDay : public AdventGUIInstance
@@ -9,128 +8,247 @@ public:
 	AdventDay(const AdventGUIParams& params) : AdventGUIInstance(params) {};
 
 private:
-	struct OpContext
+	// The three bit computer. The program is decoded once, registers are 64 bits, and the divisions by 2^combo are
+	// shifts. Output goes to a caller supplied byte buffer, a run stops early once that is full.
+	//
+	// Programs shaped like every puzzle input (one loop body ending in "jnz 0", no other jumps) are also compiled into a
+	// chain of handlers specialised on their operand, which Run executes straight through per loop iteration with no
+	// decoding or dispatch on opcode. Anything else runs on the interpreter.
+	class ThreeBitVM
 	{
-		int32_t registers[3] = { 0, 0, 0};
-		int instPtr = 0;
+	public:
+		enum Opcode : uint8_t
+		{
+			ADV = 0, // A = A >> combo
+			BXL = 1, // B = B ^ literal
+			BST = 2, // B = combo & 7
+			JNZ = 3, // if (A) jump to literal
+			BXC = 4, // B = B ^ C
+			OUT = 5, // output combo & 7
+			BDV = 6, // B = A >> combo
+			CDV = 7, // C = A >> combo
+			HALT,    // Off the end of the program.
+		};
+
+		// Upper bound on instructions per run, so a program that never halts or outputs can't hang the caller.
+		enum : uint32_t { MAX_STEPS = 1 << 24 };
+
+		void Load(const std::vector<int>& program)
+		{
+			// Jumps may land on any word, so decode an instruction at every offset. The last word has no operand and
+			// jumping there halts, just like running off the end. Targets past the end are clamped to the final HALT.
+			m_code.resize(program.size() + 1);
+			for (size_t ip = 0; ip < m_code.size(); ++ip)
+			{
+				Instruction& inst = m_code[ip];
+				if (ip + 1 >= program.size())
+				{
+					inst.opcode = HALT;
+					inst.operand = 0;
+					continue;
+				}
+
+				assert(program[ip] >= 0 && program[ip] < 8 && program[ip + 1] >= 0 && program[ip + 1] < 8);
+				inst.opcode = (uint8_t)program[ip];
+				inst.operand = (uint8_t)program[ip + 1];
+			}
 
-		int GetComboParam(int value) const
+			Compile(program);
+		}
+
+		bool IsCompiled() const { return !m_chain.empty(); }
+
+		// Runs from the given registers, returning how many values were written to outValues.
+		uint32_t Run(uint64_t a, uint64_t b, uint64_t c, uint8_t* outValues, uint32_t maxOutputs) const
 		{
-			value = value & 0x7;
-			constexpr int highBit = 1 << 2;
-			if (value & highBit)
+			if (IsCompiled())
 			{
-				// Just mask off the high bit.
-				return registers[value & ~highBit];
+				return RunCompiled(a, b, c, outValues, maxOutputs);
 			}
-			return value;
+
+			return Interpret(a, b, c, outValues, maxOutputs);
 		}
-	};
 
-	bool Exec(const OpContext& input, const std::vector<int>& program, OpContext& output)
-	{
-		if (input.instPtr >= (int)program.size())
+		uint32_t Interpret(uint64_t a, uint64_t b, uint64_t c, uint8_t* outValues, uint32_t maxOutputs) const
 		{
-			return false;
+			// Combo operands index this directly: 0-3 are literals, 4-6 the registers (7 is reserved, reads 0).
+			uint64_t combo[8] = { 0, 1, 2, 3, a, b, c, 0 };
+			uint64_t& regA = combo[4];
+			uint64_t& regB = combo[5];
+			uint64_t& regC = combo[6];
+
+			uint32_t numOutputs = 0;
+			const Instruction* code = m_code.data();
+			const size_t haltIp = m_code.size() - 1;
+			size_t ip = 0;
+			for (uint32_t step = 0; step < MAX_STEPS; ++step)
+			{
+				const Instruction inst = code[ip];
+				switch (inst.opcode)
+				{
+				case ADV: regA = Shift(regA, combo[inst.operand]); break;
+				case BXL: regB ^= inst.operand; break;
+				case BST: regB = combo[inst.operand] & 7; break;
+				case JNZ:
+					if (regA)
+					{
+						ip = std::min<size_t>(inst.operand, haltIp); // Past the end halts.
+						continue;
+					}
+					break;
+				case BXC: regB ^= regC; break;
+				case OUT:
+					outValues[numOutputs++] = (uint8_t)(combo[inst.operand] & 7);
+					if (numOutputs == maxOutputs)
+					{
+						return numOutputs;
+					}
+					break;
+				case BDV: regB = Shift(regA, combo[inst.operand]); break;
+				case CDV: regC = Shift(regA, combo[inst.operand]); break;
+				default: return numOutputs; // HALT
+				}
+
+				ip = std::min(ip + 2, haltIp);
+			}
+
+			return numOutputs;
 		}
 
-		int opCode = program[input.instPtr];
-		int arg = program[input.instPtr + 1];
-		memcpy(output.registers, input.registers, sizeof(int) * 3);
-		output.instPtr = input.instPtr;
-		switch (opCode)
+		// Runs the program once per initial A (B and C shared). Run i writes up to maxOutputs values starting at
+		// outValues + i * maxOutputs and its count to outCounts[i]. Big batches are split across threads.
+		void RunBatch(const uint64_t* initialA, size_t count, uint64_t b, uint64_t c, uint32_t maxOutputs, uint8_t* outValues, uint32_t* outCounts) const
 		{
-			case 0: // adv - A = A / 2^C(arg)
+			auto runRange = [&](uint32_t, size_t begin, size_t end)
 			{
-				int nom = input.registers[0];
-				int denom = Math::Pow(2, input.GetComboParam(arg));
-				output.registers[0] = nom / denom;
-				output.instPtr += 2;
+				for (size_t i = begin; i < end; ++i)
+				{
+					outCounts[i] = Run(initialA[i], b, c, outValues + i * maxOutputs, maxOutputs);
+				}
+			};
+
+			// Anything up to one grain runs inline on the calling thread.
+			Parallel::For(count, 256, runRange);
+		}
+
+	private:
+		struct Instruction
+		{
+			uint8_t opcode;
+			uint8_t operand;
+		};
+
+		// a / 2^amount, which is 0 once the shift is past the register width.
+		static uint64_t Shift(uint64_t value, uint64_t amount)
+		{
+			return amount < 64 ? value >> amount : 0;
+		}
 
-				Log("A = A / 2^C = %d = %d / 2^%d (%d)", output.registers[0], nom, arg, denom);
-				Log("A is now [%d] Octal [%o]", output.registers[0], output.registers[0]);
+		struct MachineState
+		{
+			uint64_t a;
+			uint64_t b;
+			uint64_t c;
+			uint8_t* outValues;
+			uint32_t numOutputs;
+			uint32_t maxOutputs;
+		};
+
+		typedef void (*Handler)(MachineState& state);
+
+		template<uint8_t Operand>
+		static uint64_t Combo(const MachineState& state)
+		{
+			static_assert(Operand < 7, "Combo operand 7 is reserved");
+			return Operand < 4 ? Operand : Operand == 4 ? state.a : Operand == 5 ? state.b : state.c;
+		}
+
+		template<uint8_t Operand> static void Adv(MachineState& state) { state.a = Shift(state.a, Combo<Operand>(state)); }
+		template<uint8_t Operand> static void Bxl(MachineState& state) { state.b ^= Operand; }
+		template<uint8_t Operand> static void Bst(MachineState& state) { state.b = Combo<Operand>(state) & 7; }
+		template<uint8_t Operand> static void Bxc(MachineState& state) { state.b ^= state.c; }
+		template<uint8_t Operand> static void Bdv(MachineState& state) { state.b = Shift(state.a, Combo<Operand>(state)); }
+		template<uint8_t Operand> static void Cdv(MachineState& state) { state.c = Shift(state.a, Combo<Operand>(state)); }
+
+		template<uint8_t Operand>
+		static void Out(MachineState& state)
+		{
+			if (state.numOutputs < state.maxOutputs)
+			{
+				state.outValues[state.numOutputs++] = (uint8_t)(Combo<Operand>(state) & 7);
 			}
-			break;
-			case 1: // bxl B = B ^ arg
+		}
+
+		// Handler for (opcode, operand), nullptr for jumps and the reserved combo operand.
+		static Handler GetHandler(uint8_t opcode, uint8_t operand)
+		{
+#define DAY17_HANDLER_ROW(Op) { &Op<0>, &Op<1>, &Op<2>, &Op<3>, &Op<4>, &Op<5>, &Op<6>, nullptr }
+			static const Handler comboHandlers[8][8] =
 			{
-				output.registers[1] = input.registers[1] ^ arg;
-				output.instPtr += 2;
+				DAY17_HANDLER_ROW(Adv), { nullptr }, DAY17_HANDLER_ROW(Bst), { nullptr },
+				{ nullptr }, DAY17_HANDLER_ROW(Out), DAY17_HANDLER_ROW(Bdv), DAY17_HANDLER_ROW(Cdv),
+			};
+#undef DAY17_HANDLER_ROW
+			static const Handler literalHandlers[8] = { &Bxl<0>, &Bxl<1>, &Bxl<2>, &Bxl<3>, &Bxl<4>, &Bxl<5>, &Bxl<6>, &Bxl<7> };
 
-				Log("B = B ^ arg  %d = %d ^ %d", output.registers[1], input.registers[1], arg);
+			switch (opcode)
+			{
+			case BXL: return literalHandlers[operand];
+			case BXC: return &Bxc<0>;
+			case JNZ: return nullptr;
+			default: return comboHandlers[opcode][operand];
 			}
-			break;
-			case 2: // bst B = C(arg) % 8
+		}
+
+		void Compile(const std::vector<int>& program)
+		{
+			m_chain.clear();
+			const size_t numWords = program.size();
+			if (numWords < 2 || (numWords & 1) || program[numWords - 2] != JNZ || program[numWords - 1] != 0)
 			{
-				int value = input.GetComboParam(arg);
-				output.registers[1] = value & 0x7;
-				output.instPtr += 2;
-				Log("B = C(arg) mod 8 %d = %d mod 8", output.registers[1], value, arg);
+				return;
 			}
-			break;
-			case 3: // jnz - jump
+
+			std::vector<Handler> chain;
+			for (size_t ip = 0; ip + 2 < numWords; ip += 2)
 			{
-				if (input.registers[0])
-				{
-					output.instPtr = arg;
-				}
-				else
+				const Handler handler = GetHandler((uint8_t)program[ip], (uint8_t)program[ip + 1]);
+				if (!handler)
 				{
-					output.instPtr += 2;
+					return;
 				}
+				chain.push_back(handler);
 			}
-			break;
-			case 4: // bxc B = B ^ C
-			{
-				output.registers[1] = input.registers[1] ^ input.registers[2];
-				output.instPtr += 2;
 
-				Log("B = B ^ C  %d = %d ^ %d", output.registers[1], input.registers[1], input.registers[2]);
-			}
-			break;
-			case 5: // output
+			m_chain.swap(chain);
+		}
+
+		uint32_t RunCompiled(uint64_t a, uint64_t b, uint64_t c, uint8_t* outValues, uint32_t maxOutputs) const
+		{
+			MachineState state = { a, b, c, outValues, 0, maxOutputs };
+			const Handler* begin = m_chain.data();
+			const Handler* end = begin + m_chain.size();
+			uint32_t stepsLeft = MAX_STEPS;
+			do
 			{
-				int value = input.GetComboParam(arg) & 0x7;
-				if (m_output.size() == 0)
+				for (const Handler* handler = begin; handler != end; ++handler)
 				{
-					m_output.insert(m_output.end(), '0' + value);
+					(*handler)(state);
 				}
-				else
+
+				if (state.numOutputs == maxOutputs || stepsLeft <= (uint32_t)m_chain.size() + 1)
 				{
-					m_output.insert(m_output.end(), ',');
-					m_output.insert(m_output.end(), '0' + value);
+					break;
 				}
-				output.instPtr += 2;
-
-				Log("Arg %d Output %d (%d) Octal [%o]", arg, value, input.GetComboParam(arg), input.GetComboParam(arg));
-			}
-			break;
-			case 6:
-			{
-				int nom = input.registers[0];
-				int denom = Math::Pow(2, input.GetComboParam(arg));
-				output.registers[1] = nom / denom;
-				output.instPtr += 2;
-
-				Log("B = A / 2^C = %d = %d / 2^%d (%d)", output.registers[1], nom, arg, denom);
-			}
-			break;
-			case 7:
-			{
-				int nom = input.registers[0];
-				int denom = Math::Pow(2, input.GetComboParam(arg));
-				output.registers[2] = nom / denom;
-				output.instPtr += 2;
+				stepsLeft -= (uint32_t)m_chain.size() + 1;
+			} while (state.a != 0);
 
-				Log("C = A / 2^C = %d = %d / 2^%d (%d)", output.registers[2], nom, arg, denom);
-			}
-			break;
-			default:
-			assert(false);
-			break;
+			return state.numOutputs;
 		}
 
-		return true;
-	}
+		std::vector<Instruction> m_code;
+		std::vector<Handler> m_chain; // Loop body, empty if the program didn't fit the compiled shape.
+	};
 
 	virtual void ParseInput(FileStreamReader& fileReader) override
 	{
@@ -139,29 +257,20 @@ private:
 		std::vector<std::string> tokens;
 		if (!fileReader.IsEOF())
 		{
-			// Reg A
-			line = fileReader.ReadLine();
-			size_t colonIdx = line.rfind(':');
-			assert(colonIdx != std::string::npos);
-			m_startContext.registers[0] = atoi(line.substr(colonIdx + 1).c_str());
-
-			// Reg B
-			line = fileReader.ReadLine();
-			colonIdx = line.rfind(':');
-			assert(colonIdx != std::string::npos);
-			m_startContext.registers[1] = atoi(line.substr(colonIdx + 1).c_str());
-
-			// Reg C
-			line = fileReader.ReadLine();
-			colonIdx = line.rfind(':');
-			assert(colonIdx != std::string::npos);
-			m_startContext.registers[2] = atoi(line.substr(colonIdx + 1).c_str());
+			// Registers A, B, C.
+			for (uint64_t& reg : m_startRegisters)
+			{
+				line = fileReader.ReadLine();
+				size_t colonIdx = line.rfind(':');
+				assert(colonIdx != std::string::npos);
+				reg = strtoull(line.c_str() + colonIdx + 1, nullptr, 10);
+			}
 
 			line = fileReader.ReadLine();
 			assert(line.size() == 0);
 
 			line = fileReader.ReadLine();
-			colonIdx = line.rfind(':');
+			size_t colonIdx = line.rfind(':');
 			assert(colonIdx != std::string::npos);
 			m_rawProgram = line.substr(colonIdx + 2).c_str();
 
@@ -171,88 +280,182 @@ private:
 				m_program.push_back(atoi(tokens[i].c_str()));
 			}
 		}
+
+		m_vm.Load(m_program);
 	}
 
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
-		OpContext pingPong[2] = { m_startContext, OpContext()};
-		int ppIdx = 0;
-		initialA = m_startContext.registers[0];
-		while (Exec(pingPong[ppIdx], m_program, pingPong[ppIdx ^ 1]))
+		std::vector<uint8_t> values(1 << 16);
+		const uint32_t numValues = m_vm.Run(m_startRegisters[0], m_startRegisters[1], m_startRegisters[2], values.data(), (uint32_t)values.size());
+
+		std::string output;
+		for (uint32_t i = 0; i < numValues; ++i)
 		{
-			ppIdx ^= 1;
+			output += i ? "," : "";
+			output += (char)('0' + values[i]);
 		}
-		Log("Output: %s", m_output.c_str());
-
-		Log("Done.");
+		Log("Output: %s", output.c_str());
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
 	}
 
-	std::vector<int> GetOctal(uint64_t A) const
+	// The quine search relies on the program being a single loop that, per iteration, outputs one value computed only
+	// from A (B and C written before they're read) and then drops a fixed number of low bits from A. Output i is then a
+	// function of A >> (shift * i) alone, so A can be fixed a digit of shift bits at a time from the top. Returns that
+	// shift, or 0 if the program doesn't have the structure.
+	uint32_t GetLoopShift() const
 	{
-		uint64_t B = 0;
-		uint64_t C = 0;
-		uint64_t lastValue = 0;
-		std::vector<int> outValues;
+		const size_t numWords = m_program.size();
+		if (numWords < 2 || (numWords & 1) || m_program[numWords - 2] != ThreeBitVM::JNZ || m_program[numWords - 1] != 0)
+		{
+			return 0;
+		}
 
-		while (A != 0)
+		uint32_t shift = 0;
+		uint32_t numShifts = 0;
+		uint32_t numOutputs = 0;
+		bool wroteB = false;
+		bool wroteC = false;
+		auto readsOk = [&](int combo) { return (combo != 5 || wroteB) && (combo != 6 || wroteC) && combo != 7; };
+		for (size_t ip = 0; ip + 2 < numWords; ip += 2)
 		{
-			B = A % 8ULL;
-			B ^= 3ULL;
-			C = A / (1ULL << B);
-			B ^= C;
-			B ^= 3ULL;
-			A = A / (1ULL << 3ULL);
-
-			outValues.push_back(B % 8ULL);
+			const int operand = m_program[ip + 1];
+			switch (m_program[ip])
+			{
+			case ThreeBitVM::ADV:
+				if (operand == 0 || operand > 3)
+				{
+					return 0; // A has to shrink by a constant amount.
+				}
+				shift = (uint32_t)operand;
+				++numShifts;
+				break;
+			case ThreeBitVM::BXL:
+				if (!wroteB)
+				{
+					return 0;
+				}
+				break;
+			case ThreeBitVM::BXC:
+				if (!wroteB || !wroteC)
+				{
+					return 0;
+				}
+				break;
+			case ThreeBitVM::OUT:
+				if (!readsOk(operand))
+				{
+					return 0;
+				}
+				++numOutputs;
+				break;
+			case ThreeBitVM::BST:
+			case ThreeBitVM::BDV:
+			case ThreeBitVM::CDV:
+				if (!readsOk(operand))
+				{
+					return 0;
+				}
+				wroteB |= m_program[ip] != ThreeBitVM::CDV;
+				wroteC |= m_program[ip] == ThreeBitVM::CDV;
+				break;
+			default:
+				return 0; // A second jump.
+			}
+		}
+
+		// A needs shift * length bits, which has to fit.
+		if (numShifts != 1 || numOutputs != 1 || shift * numWords > 64)
+		{
+			return 0;
 		}
 
-		return outValues;
+		return shift;
 	}
 
-	uint64_t RecursiveCheck(uint64_t A, int Index) const
-	{	
-		std::vector<int> testValues;
-		for (uint64_t i = 0; i < 8; ++i)
+	// Search over A's digits, most significant first, one level at a time. A prefix survives if running it reproduces
+	// that many values from the back of the program, and prefixes whose smallest completion is past maxA are dropped.
+	// Every child of every surviving prefix is checked in one batch per level, so a wide frontier spreads across threads
+	// in RunBatch. Children come out in order of an ordered frontier, so the solutions (every valid A up to maxA) end up
+	// in increasing order.
+	void FindQuines(uint32_t shift, uint64_t maxA, std::vector<uint64_t>& outSolutions) const
+	{
+		const uint32_t length = (uint32_t)m_program.size();
+		const uint32_t numChildren = 1U << shift;
+		std::vector<uint64_t> frontier(1, 0);
+		std::vector<uint64_t> children;
+		std::vector<uint8_t> outputs;
+		std::vector<uint32_t> counts;
+		for (uint32_t numDigits = 1; numDigits <= length && !frontier.empty(); ++numDigits)
 		{
-			testValues = GetOctal(A + i);
-			if (testValues.size() && testValues.front() == m_program[m_program.size() - Index - 1])
+			children.resize(frontier.size() * numChildren);
+			for (size_t p = 0; p < frontier.size(); ++p)
 			{
-				if (Index + 1 == m_program.size())
+				for (uint32_t digit = 0; digit < numChildren; ++digit)
 				{
-					return A + i;
+					children[p * numChildren + digit] = (frontier[p] << shift) | digit;
 				}
+			}
+
+			// Leading zero digits produce too few values and drop out on the count check.
+			const int* expected = m_program.data() + length - numDigits;
+			outputs.resize(children.size() * (length + 1));
+			counts.resize(children.size());
+			m_vm.RunBatch(children.data(), children.size(), m_startRegisters[1], m_startRegisters[2], length + 1, outputs.data(), counts.data());
 
-				uint64_t next = RecursiveCheck((A + i) << 3ULL, Index + 1);
-				if (next != 0)
+			frontier.clear();
+			for (size_t i = 0; i < children.size(); ++i)
+			{
+				const uint8_t* values = outputs.data() + i * (length + 1);
+				if (counts[i] != numDigits || !std::equal(values, values + numDigits, expected))
+				{
+					continue;
+				}
+
+				const uint64_t lowestA = children[i] << (shift * (length - numDigits));
+				if (lowestA <= maxA)
 				{
-					return next;
+					frontier.push_back(children[i]);
 				}
 			}
 		}
 
-		return 0;
+		outSolutions.swap(frontier);
 	}
 
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
-		uint64_t key = RecursiveCheck(0, 0);
-
-		Log("Key = %u", key);
+		const uint32_t shift = GetLoopShift();
+		if (shift == 0)
+		{
+			Log("Program isn't a single loop consuming A at a fixed rate, can't search for a quine.");
+		}
+		else
+		{
+			std::vector<uint64_t> solutions;
+			FindQuines(shift, ~0ULL, solutions);
+			if (solutions.empty())
+			{
+				Log("No quine found.");
+			}
+			else
+			{
+				Log("Key = %llu (%zd valid values of A, largest %llu)", solutions.front(), solutions.size(), solutions.back());
+			}
+		}
 
 		// Done.
 		AdventGUIInstance::PartTwo(context);
 	}
 
-	OpContext m_startContext;
+	uint64_t m_startRegisters[3] = { 0, 0, 0 };
 	std::vector<int> m_program;
 	std::string m_rawProgram;
-	std::string m_output;
-	int initialA;
+	ThreeBitVM m_vm;
 };
 
 int main()
@@ -1,6 +1,6 @@
 #include "AdventGUI/AdventGUI.h"
-#include "ACUtils/Algorithm.h"
-#include "ACUtils/IntVec.h"
+#include "ACUtils/Parallel.h"
+#include <atomic>
 
 
 class AdventDay : public AdventGUIInstance
@@ -25,77 +25,154 @@ private:
 		while (!fileReader.IsEOF())
 		{
 			line = fileReader.ReadLine();
-			m_inputs.push_back(line);
+			if (!line.empty())
+			{
+				m_inputs.push_back(line);
+			}
 		}
 
-		std::sort(m_keys.begin(), m_keys.end(), [](const std::string& LHS, const std::string& RHS){ return LHS.size() > RHS.size(); });
-
+		m_trie.Build(m_keys);
 	}
 
-	bool IsValidPerm(const std::string& desired, size_t offset) const
+	// Trie over the towel patterns, flat with one child slot per symbol actually used by a pattern. Symbols are mapped to
+	// dense indices through a byte table, anything that never appears in a pattern can't match.
+	class TowelTrie
 	{
-		if (offset == desired.size())
+	public:
+		enum : uint32_t { ROOT = 0, NO_NODE = ~0U };
+
+		void Build(const std::vector<std::string>& patterns)
 		{
-			return true;
+			memset(m_symbolIndex, 0xFF, sizeof(m_symbolIndex));
+			m_numSymbols = 0;
+			for (const std::string& pattern : patterns)
+			{
+				for (char c : pattern)
+				{
+					if (m_symbolIndex[(uint8_t)c] == NO_SYMBOL)
+					{
+						m_symbolIndex[(uint8_t)c] = (uint8_t)m_numSymbols++;
+					}
+				}
+			}
 
+			m_children.assign(m_numSymbols, NO_NODE);
+			m_isTerminal.assign(1, 0);
+			for (const std::string& pattern : patterns)
+			{
+				uint32_t node = ROOT;
+				for (char c : pattern)
+				{
+					const size_t slot = (size_t)node * m_numSymbols + m_symbolIndex[(uint8_t)c];
+					if (m_children[slot] == NO_NODE)
+					{
+						m_children[slot] = (uint32_t)m_isTerminal.size();
+						m_isTerminal.push_back(0);
+						m_children.resize(m_children.size() + m_numSymbols, NO_NODE);
+					}
+					node = m_children[slot];
+				}
+				m_isTerminal[node] = 1;
+			}
 		}
 
-		for (const std::string& key : m_keys)
+		// Calls func(length) for every pattern that matches text at its start, shortest first.
+		template<typename Func>
+		void ForEachMatch(const char* text, size_t textLength, Func&& func) const
 		{
-			if (desired.compare(offset, key.size(), key) == 0)
+			uint32_t node = ROOT;
+			for (size_t i = 0; i < textLength; ++i)
 			{
-				if (IsValidPerm(desired, offset + key.size()))
+				const uint8_t symbol = m_symbolIndex[(uint8_t)text[i]];
+				if (symbol == NO_SYMBOL)
+				{
+					return;
+				}
+
+				node = m_children[(size_t)node * m_numSymbols + symbol];
+				if (node == NO_NODE)
 				{
-					return true;
+					return;
+				}
+
+				if (m_isTerminal[node])
+				{
+					func(i + 1);
 				}
 			}
 		}
 
-		return false;
-	}
+	private:
+		enum : uint8_t { NO_SYMBOL = 0xFF };
 
-	uint64_t CountValidPerm(const std::string& desired, size_t offset, std::unordered_map<std::string, uint64_t>& cache) const
-	{
-		if (offset == desired.size())
-		{
-			return 1;
-		}
+		uint8_t m_symbolIndex[256];
+		uint32_t m_numSymbols = 0;
+		std::vector<uint32_t> m_children; // m_numSymbols entries per node.
+		std::vector<uint8_t> m_isTerminal;
+	};
 
-		std::unordered_map<std::string, uint64_t>::const_iterator itFind = cache.find(desired.substr(offset));
-		if (itFind != cache.end())
+	// One left to right pass per design: ways[i] is the number of ways to lay out the first i stripes, and every pattern
+	// matching at i adds it to ways[i + length]. Reachability is tracked separately so a count that wraps can't make a
+	// possible design look impossible. Designs are independent, so they're spread across threads. The pass answers both
+	// parts, whichever runs first does it.
+	void MatchDesigns()
+	{
+		if (m_hasMatched)
 		{
-			return itFind->second;
+			return;
 		}
+		m_hasMatched = true;
 
-		uint64_t validCount = 0;
+		std::atomic<uint32_t> numPossible(0);
+		std::atomic<uint64_t> totalWays(0);
+		std::vector<std::vector<uint64_t>> threadWays(Parallel::GetNumThreads());
+		std::vector<std::vector<uint8_t>> threadReachable(Parallel::GetNumThreads());
 
-		for (const std::string& key : m_keys)
+		Parallel::For(m_inputs.size(), 16, [&](uint32_t threadIndex, size_t begin, size_t end)
 		{
-			if (desired.compare(offset, key.size(), key) == 0)
+			std::vector<uint64_t>& ways = threadWays[threadIndex];
+			std::vector<uint8_t>& reachable = threadReachable[threadIndex];
+			uint32_t localPossible = 0;
+			uint64_t localWays = 0;
+			for (size_t d = begin; d < end; ++d)
 			{
-				validCount += CountValidPerm(desired, offset + key.size(), cache);
+				const std::string& design = m_inputs[d];
+				const size_t length = design.size();
+				ways.assign(length + 1, 0);
+				reachable.assign(length + 1, 0);
+				ways[0] = 1;
+				reachable[0] = 1;
+				for (size_t i = 0; i < length; ++i)
+				{
+					if (!reachable[i])
+					{
+						continue;
+					}
+
+					m_trie.ForEachMatch(design.c_str() + i, length - i, [&](size_t matchLength)
+					{
+						ways[i + matchLength] += ways[i];
+						reachable[i + matchLength] = 1;
+					});
+				}
+
+				localPossible += reachable[length];
+				localWays += ways[length];
 			}
-		}
 
-		cache.insert(std::make_pair(desired.substr(offset), validCount));
+			numPossible += localPossible;
+			totalWays += localWays;
+		});
 
-		return validCount;
+		m_numPossible = numPossible;
+		m_totalWays = totalWays;
 	}
 
 	virtual void PartOne(const AdventGUIContext& context) override
 	{
 		// Part One
-		int totalValid = 0;
-
-		for (const std::string& input : m_inputs)
-		{
-			if (IsValidPerm(input, 0))
-			{
-				++totalValid;
-			}
-		}
-
-		Log("Total Valid = %d", totalValid);
+		MatchDesigns();
+		Log("Total Valid = %u", m_numPossible);
 
 		// Done.
 		AdventGUIInstance::PartOne(context);
@@ -104,21 +181,19 @@ private:
 	virtual void PartTwo(const AdventGUIContext& context) override
 	{
 		// Part Two
-		uint64_t totalValid = 0;
-		std::unordered_map<std::string, uint64_t> cache;
-
-		for (const std::string& input : m_inputs)
-		{
-			totalValid += CountValidPerm(input, 0, cache);
-		}
-
-		Log("Total Valid = %u", totalValid);
+		MatchDesigns();
+		Log("Total Valid = %llu", m_totalWays);
 
 		// Done.
 		AdventGUIInstance::PartTwo(context);
 	}
+
 	std::vector<std::string> m_keys;
 	std::vector<std::string> m_inputs;
+	TowelTrie m_trie;
+	uint32_t m_numPossible = 0;
+	uint64_t m_totalWays = 0;
+	bool m_hasMatched = false;
 };
 
 int main()